@@ -0,0 +1,623 @@
+#include "address_book.h"
+#include "async_address_book.h"
+#include "compressed_address_book.h"
+#include "bench_data.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <map>
+#include <memory_resource>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+
+// Memory accounting
+// Every allocation made through operator new is prefixed with its size so we can keep track of the number of live bytes
+// and report how much memory an address book uses. The std::pmr resources use the aligned overloads so those are
+// counted too.
+static std::atomic<size_t> live_bytes{ 0 };
+
+// Allocate size bytes behind a header of header_size bytes (a multiple of alignment) that remembers the size
+static void* countedAllocate(size_t size, size_t alignment)
+{
+	size_t header_size = std::max(alignment, alignof(std::max_align_t));
+	void* block = alignment > alignof(std::max_align_t)
+		? std::aligned_alloc(alignment, (header_size + size + alignment - 1) / alignment * alignment)
+		: std::malloc(header_size + size);
+	if (block == nullptr) {
+		throw std::bad_alloc();
+	}
+	*static_cast<size_t*>(block) = size;
+	live_bytes += size;
+	return static_cast<char*>(block) + header_size;
+}
+
+static void countedDeallocate(void* memory, size_t alignment) noexcept
+{
+	if (memory == nullptr) {
+		return;
+	}
+	size_t header_size = std::max(alignment, alignof(std::max_align_t));
+	void* block = static_cast<char*>(memory) - header_size;
+	live_bytes -= *static_cast<size_t*>(block);
+	std::free(block);
+}
+
+void* operator new(size_t size) { return countedAllocate(size, alignof(std::max_align_t)); }
+void* operator new(size_t size, std::align_val_t alignment) { return countedAllocate(size, static_cast<size_t>(alignment)); }
+void operator delete(void* memory) noexcept { countedDeallocate(memory, alignof(std::max_align_t)); }
+void operator delete(void* memory, size_t) noexcept { countedDeallocate(memory, alignof(std::max_align_t)); }
+void operator delete(void* memory, std::align_val_t alignment) noexcept { countedDeallocate(memory, static_cast<size_t>(alignment)); }
+void operator delete(void* memory, size_t, std::align_val_t alignment) noexcept { countedDeallocate(memory, static_cast<size_t>(alignment)); }
+
+
+// Largest address book size benchmarked (set by the ADDRESSBOOK_BENCH_MAX_SIZE cmake cache variable)
+#ifndef ADDRESSBOOK_BENCH_MAX_SIZE
+#define ADDRESSBOOK_BENCH_MAX_SIZE 100000
+#endif
+static constexpr int64_t max_size = ADDRESSBOOK_BENCH_MAX_SIZE;
+
+// remove rebuilds the maps every call (O(n log n)) so it is only benchmarked up to this size
+static constexpr int64_t max_remove_size = std::min<int64_t>(max_size, 100000);
+
+// Removing a batch of n / 20 entries one at a time rebuilds the maps on every remove (O(n^2 log n)) so the individual
+// mixed batch is only benchmarked up to this size
+static constexpr int64_t max_individual_batch_size = std::min<int64_t>(max_size, 10000);
+
+
+/// An address book of a given size, built once and shared by every benchmark that needs that size
+struct SharedBook
+{
+	AddressBook book;
+	std::vector<AddressBook::Entry> entries;
+	// Live heap bytes owned by the address book right after it was built
+	size_t bytes;
+};
+
+
+// Build (or reuse) an address book of size distinct Zipfian entries
+static SharedBook& sharedBook(size_t size)
+{
+	static std::map<size_t, std::unique_ptr<SharedBook>> books;
+
+	auto& shared = books[size];
+	if (!shared) {
+		shared = std::make_unique<SharedBook>();
+		shared->entries = bench_data::makeEntries(size);
+
+		size_t bytes_before = live_bytes;
+		for (const AddressBook::Entry& entry : shared->entries) {
+			shared->book.add(entry);
+		}
+		shared->bytes = live_bytes - bytes_before;
+	}
+	return *shared;
+}
+
+
+// Report how big the address book used by a benchmark is
+static void reportMemory(benchmark::State& state, const SharedBook& shared)
+{
+	state.counters["book_bytes"] = static_cast<double>(shared.bytes);
+	state.counters["bytes_per_entry"] = static_cast<double>(shared.bytes) / shared.entries.size();
+}
+
+
+// Prefixes people actually search for: the first one or two letters of popular (Zipfian) names
+static std::vector<std::string> makePrefixes(const std::vector<AddressBook::Entry>& entries)
+{
+	std::vector<std::string> prefixes;
+	for (size_t i = 0; i < 1024; i++) {
+		const AddressBook::Entry& entry = entries[(i * 7919) % entries.size()];
+		const std::string& name = i % 2 == 0 ? entry.first_name : entry.last_name;
+		prefixes.push_back(name.substr(0, 1 + i % 2));
+	}
+	return prefixes;
+}
+
+
+static void BM_Add(benchmark::State& state)
+{
+	SharedBook& shared = sharedBook(state.range(0));
+	std::vector<AddressBook::Entry> new_entries = bench_data::makeEntries(100000, 7);
+
+	AddressBook book = shared.book;
+	size_t next = 0;
+	for (auto _ : state) {
+		// Start again from the shared book once every new entry has been added
+		if (next == new_entries.size()) {
+			state.PauseTiming();
+			book = shared.book;
+			next = 0;
+			state.ResumeTiming();
+		}
+		book.add(new_entries[next++]);
+	}
+
+	reportMemory(state, shared);
+	state.SetItemsProcessed(state.iterations());
+}
+
+
+static void BM_AddDuplicate(benchmark::State& state)
+{
+	SharedBook& shared = sharedBook(state.range(0));
+
+	size_t next = 0;
+	for (auto _ : state) {
+		try {
+			shared.book.add(shared.entries[next]);
+		}
+		catch (std::invalid_argument& e) {} // Always a duplicate
+		next = (next + 1) % shared.entries.size();
+	}
+
+	reportMemory(state, shared);
+	state.SetItemsProcessed(state.iterations());
+}
+
+
+// Add a stream of entries where every other one is already in the address book, either catching the exception add
+// throws for the duplicates or checking the status tryAdd returns
+static void BM_AddHalfDuplicates(benchmark::State& state, bool use_status)
+{
+	SharedBook& shared = sharedBook(state.range(0));
+	std::vector<AddressBook::Entry> new_entries = bench_data::makeEntries(100000, 7);
+
+	AddressBook book = shared.book;
+	size_t next = 0;
+	size_t duplicates = 0;
+	for (auto _ : state) {
+		// Start again from the shared book once every new entry has been added
+		if (next == 2 * new_entries.size()) {
+			state.PauseTiming();
+			book = shared.book;
+			next = 0;
+			state.ResumeTiming();
+		}
+
+		const AddressBook::Entry& entry = next % 2 == 0 ? new_entries[next / 2]
+			: shared.entries[(next / 2) % shared.entries.size()];
+		next++;
+		if (use_status) {
+			duplicates += book.tryAdd(entry) == AddressBook::Status::AlreadyExists;
+		}
+		else {
+			try {
+				book.add(entry);
+			}
+			catch (std::invalid_argument& e) {
+				duplicates++;
+			}
+		}
+	}
+
+	reportMemory(state, shared);
+	state.counters["duplicate_ratio"] = static_cast<double>(duplicates) / state.iterations();
+	state.SetItemsProcessed(state.iterations());
+}
+
+
+static void BM_Remove(benchmark::State& state)
+{
+	SharedBook& shared = sharedBook(state.range(0));
+	AddressBook book = shared.book;
+
+	size_t next = 0;
+	for (auto _ : state) {
+		book.remove(shared.entries[next]);
+
+		// Put the entry back so the address book stays the same size
+		state.PauseTiming();
+		book.add(shared.entries[next]);
+		next = (next + 1) % shared.entries.size();
+		state.ResumeTiming();
+	}
+
+	reportMemory(state, shared);
+	state.SetItemsProcessed(state.iterations());
+}
+
+
+// Remove entries that aren't in the address book, the Bloom filter turns most of them away without a map lookup
+// Either catches the exception remove throws or checks the status tryRemove returns
+static void BM_RemoveMissing(benchmark::State& state, bool use_status)
+{
+	SharedBook& shared = sharedBook(state.range(0));
+	std::vector<AddressBook::Entry> missing_entries = bench_data::makeEntries(10000, 7);
+
+	size_t next = 0;
+	for (auto _ : state) {
+		if (use_status) {
+			benchmark::DoNotOptimize(shared.book.tryRemove(missing_entries[next]));
+		}
+		else {
+			try {
+				shared.book.remove(missing_entries[next]);
+			}
+			catch (std::invalid_argument& e) {} // Not in the address book
+		}
+		next = (next + 1) % missing_entries.size();
+	}
+
+	reportMemory(state, shared);
+	state.SetItemsProcessed(state.iterations());
+}
+
+
+// Look up whole names that no entry has
+static void BM_FindExactMissing(benchmark::State& state)
+{
+	SharedBook& shared = sharedBook(state.range(0));
+	std::vector<std::string> missing_names;
+	for (size_t i = 0; i < 1024; i++) {
+		missing_names.push_back(shared.entries[(i * 7919) % shared.entries.size()].last_name + "x" + std::to_string(i));
+	}
+
+	size_t next = 0;
+	for (auto _ : state) {
+		std::vector<AddressBook::Entry> results = shared.book.findExact(missing_names[next]);
+		benchmark::DoNotOptimize(results);
+		next = (next + 1) % missing_names.size();
+	}
+
+	reportMemory(state, shared);
+	state.SetItemsProcessed(state.iterations());
+}
+
+
+static void BM_Find(benchmark::State& state)
+{
+	SharedBook& shared = sharedBook(state.range(0));
+	std::vector<std::string> prefixes = makePrefixes(shared.entries);
+
+	size_t next = 0;
+	size_t found = 0;
+	for (auto _ : state) {
+		std::vector<AddressBook::Entry> results = shared.book.find(prefixes[next]);
+		found += results.size();
+		benchmark::DoNotOptimize(results);
+		next = (next + 1) % prefixes.size();
+	}
+
+	reportMemory(state, shared);
+	state.counters["results_per_find"] = static_cast<double>(found) / state.iterations();
+	state.SetItemsProcessed(state.iterations());
+}
+
+
+static void BM_SortedByFirstName(benchmark::State& state)
+{
+	SharedBook& shared = sharedBook(state.range(0));
+
+	for (auto _ : state) {
+		std::vector<AddressBook::Entry> results = shared.book.sortedByFirstName();
+		benchmark::DoNotOptimize(results);
+	}
+
+	reportMemory(state, shared);
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+
+// Time until the first chunk of a sorted listing reaches the caller through the async front end, compare with
+// BM_SortedByFirstName which has to build the whole listing first
+static void BM_SortedByFirstNameAsyncFirstChunk(benchmark::State& state)
+{
+	SharedBook& shared = sharedBook(state.range(0));
+	AsyncAddressBook async_book(shared.book);
+
+	auto firstChunk = [](AsyncAddressBook& async_book) -> Task<size_t> {
+		AsyncGenerator<std::vector<AddressBook::Entry>> chunks = async_book.sortedByFirstNameAsync();
+		std::optional<std::vector<AddressBook::Entry>> chunk = co_await chunks.next();
+		co_return chunk ? chunk->size() : 0;
+	};
+
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(syncWait(firstChunk(async_book)));
+	}
+
+	reportMemory(state, shared);
+	state.SetItemsProcessed(state.iterations());
+}
+
+
+static void BM_SortedByLastName(benchmark::State& state)
+{
+	SharedBook& shared = sharedBook(state.range(0));
+
+	for (auto _ : state) {
+		std::vector<AddressBook::Entry> results = shared.book.sortedByLastName();
+		benchmark::DoNotOptimize(results);
+	}
+
+	reportMemory(state, shared);
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+
+static void BM_Plus(benchmark::State& state)
+{
+	SharedBook& shared = sharedBook(state.range(0));
+
+	// Half of rhs is already in the address book, the other half is new
+	AddressBook rhs;
+	for (size_t i = 0; i < shared.entries.size() / 4; i++) {
+		rhs.add(shared.entries[i * 2]);
+	}
+	for (const AddressBook::Entry& entry : bench_data::makeEntries(shared.entries.size() / 4, 7)) {
+		rhs.add(entry);
+	}
+
+	for (auto _ : state) {
+		AddressBook result = shared.book + rhs;
+		benchmark::DoNotOptimize(result);
+	}
+
+	reportMemory(state, shared);
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+
+static void BM_Minus(benchmark::State& state)
+{
+	SharedBook& shared = sharedBook(state.range(0));
+
+	// Half of rhs is in the address book, the other half isn't
+	AddressBook rhs;
+	for (size_t i = 0; i < shared.entries.size() / 20; i++) {
+		rhs.add(shared.entries[i * 10]);
+	}
+	for (const AddressBook::Entry& entry : bench_data::makeEntries(shared.entries.size() / 20, 7)) {
+		rhs.add(entry);
+	}
+
+	for (auto _ : state) {
+		// operator- removes the entries from its left hand side so it needs a fresh copy every time
+		state.PauseTiming();
+		AddressBook lhs = shared.book;
+		state.ResumeTiming();
+
+		AddressBook result = lhs - rhs;
+		benchmark::DoNotOptimize(result);
+	}
+
+	reportMemory(state, shared);
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+
+// Take a compressed snapshot of the shared address book and report how big it is next to the address book
+static std::unique_ptr<CompressedAddressBook> compressSharedBook(benchmark::State& state, const SharedBook& shared)
+{
+	size_t bytes_before = live_bytes;
+	auto compressed = std::make_unique<CompressedAddressBook>(shared.book);
+	size_t bytes = live_bytes - bytes_before;
+
+	reportMemory(state, shared);
+	state.counters["compressed_bytes"] = static_cast<double>(bytes);
+	state.counters["compressed_bytes_per_entry"] = static_cast<double>(bytes) / shared.entries.size();
+	return compressed;
+}
+
+
+static void BM_CompressedFind(benchmark::State& state)
+{
+	SharedBook& shared = sharedBook(state.range(0));
+	std::unique_ptr<CompressedAddressBook> compressed = compressSharedBook(state, shared);
+	std::vector<std::string> prefixes = makePrefixes(shared.entries);
+
+	size_t next = 0;
+	size_t found = 0;
+	for (auto _ : state) {
+		std::vector<AddressBook::Entry> results = compressed->find(prefixes[next]);
+		found += results.size();
+		benchmark::DoNotOptimize(results);
+		next = (next + 1) % prefixes.size();
+	}
+
+	state.counters["results_per_find"] = static_cast<double>(found) / state.iterations();
+	state.SetItemsProcessed(state.iterations());
+}
+
+
+static void BM_CompressedSortedByFirstName(benchmark::State& state)
+{
+	SharedBook& shared = sharedBook(state.range(0));
+	std::unique_ptr<CompressedAddressBook> compressed = compressSharedBook(state, shared);
+
+	for (auto _ : state) {
+		std::vector<AddressBook::Entry> results = compressed->sortedByFirstName();
+		benchmark::DoNotOptimize(results);
+	}
+
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+
+// Which set operation BM_SetOperationScaling runs
+enum class SetOperation
+{
+	Union,
+	Difference,
+	Intersection
+};
+
+
+// Run a set operation of two address books of state.range(0) entries on a pool of state.range(1) threads in total
+// (the calling thread is one of them), for checking how well the partitioned set operations scale
+static void BM_SetOperationScaling(benchmark::State& state, SetOperation operation)
+{
+	SharedBook& shared = sharedBook(state.range(0));
+	size_t thread_count = static_cast<size_t>(state.range(1));
+
+	// Half of rhs is in the address book, the other half isn't
+	AddressBook rhs;
+	for (size_t i = 0; i < shared.entries.size() / 2; i++) {
+		rhs.add(shared.entries[i * 2]);
+	}
+	AddressBook::Transaction new_entries = rhs.begin();
+	for (const AddressBook::Entry& entry : bench_data::makeEntries(shared.entries.size() / 2, 7)) {
+		new_entries.add(entry);
+	}
+	new_entries.commit();
+
+	WorkStealingPool pool(thread_count - 1);
+	for (auto _ : state) {
+		AddressBook result = operation == SetOperation::Union ? shared.book.unionWith(rhs, pool)
+			: operation == SetOperation::Difference ? shared.book.differenceWith(rhs, pool)
+			: shared.book.intersectionWith(rhs, pool);
+		benchmark::DoNotOptimize(result);
+	}
+
+	state.counters["threads"] = static_cast<double>(thread_count);
+	state.SetItemsProcessed(state.iterations() * state.range(0) * 2);
+}
+
+
+// Build a whole address book of state.range(0) entries from scratch, allocating from the resource made by MakeResource
+template <typename MakeResource>
+static void BM_BuildBook(benchmark::State& state, MakeResource make_resource)
+{
+	std::vector<AddressBook::Entry> entries = bench_data::makeEntries(state.range(0));
+
+	for (auto _ : state) {
+		auto resource = make_resource();
+		AddressBook book(resource.get());
+		for (const AddressBook::Entry& entry : entries) {
+			book.add(entry);
+		}
+		benchmark::DoNotOptimize(book);
+	}
+
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+
+// A sync job style batch on a copy of the book: remove every 20th entry and add as many new entries, either one call
+// at a time or as a single transaction
+static void BM_MixedBatch(benchmark::State& state, bool use_transaction)
+{
+	SharedBook& shared = sharedBook(state.range(0));
+	std::vector<AddressBook::Entry> new_entries = bench_data::makeEntries(shared.entries.size() / 20, 7);
+
+	for (auto _ : state) {
+		state.PauseTiming();
+		AddressBook book = shared.book;
+		state.ResumeTiming();
+
+		if (use_transaction) {
+			auto transaction = book.begin();
+			for (size_t i = 0; i < new_entries.size(); i++) {
+				transaction.remove(shared.entries[i * 20]);
+				transaction.add(new_entries[i]);
+			}
+			transaction.commit();
+		}
+		else {
+			for (size_t i = 0; i < new_entries.size(); i++) {
+				book.remove(shared.entries[i * 20]);
+				book.add(new_entries[i]);
+			}
+		}
+		benchmark::DoNotOptimize(book);
+	}
+
+	reportMemory(state, shared);
+	state.SetItemsProcessed(state.iterations() * new_entries.size() * 2);
+}
+
+
+// Building an address book with the indexes chosen by Policy, to compare what each index costs
+template <typename Policy>
+static void BM_BuildBookPolicy(benchmark::State& state)
+{
+	std::vector<AddressBook::Entry> entries = bench_data::makeEntries(state.range(0));
+
+	size_t bytes = 0;
+	for (auto _ : state) {
+		size_t bytes_before = live_bytes;
+		BasicAddressBook<Policy> book;
+		for (const AddressBook::Entry& entry : entries) {
+			book.add(entry);
+		}
+		bytes = live_bytes - bytes_before;
+		benchmark::DoNotOptimize(book);
+	}
+
+	state.counters["book_bytes"] = static_cast<double>(bytes);
+	state.counters["bytes_per_entry"] = static_cast<double>(bytes) / entries.size();
+	state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+
+// find with the results and scratch memory coming from a request scoped arena that is released after every query
+static void BM_FindArena(benchmark::State& state)
+{
+	SharedBook& shared = sharedBook(state.range(0));
+	std::vector<std::string> prefixes = makePrefixes(shared.entries);
+
+	// Back the arena with a preallocated buffer, like a request handler reusing its arena between requests
+	std::vector<std::byte> arena_buffer(1 << 22);
+	std::pmr::monotonic_buffer_resource arena(arena_buffer.data(), arena_buffer.size());
+	size_t next = 0;
+	for (auto _ : state) {
+		{
+			std::pmr::vector<AddressBook::Entry> results = shared.book.find(prefixes[next], &arena);
+			benchmark::DoNotOptimize(results);
+		}
+		arena.release();
+		next = (next + 1) % prefixes.size();
+	}
+
+	reportMemory(state, shared);
+	state.SetItemsProcessed(state.iterations());
+}
+
+
+// Memory resources compared by BM_BuildBook
+// The default resource is wrapped in a deleter that does nothing so every variant hands out a unique_ptr
+static auto default_resource = []() {
+	return std::unique_ptr<std::pmr::memory_resource, void (*)(std::pmr::memory_resource*)>(
+		std::pmr::get_default_resource(), [](std::pmr::memory_resource*) {});
+};
+static auto pool_resource = []() { return std::make_unique<std::pmr::unsynchronized_pool_resource>(); };
+static auto monotonic_resource = []() { return std::make_unique<std::pmr::monotonic_buffer_resource>(); };
+
+
+BENCHMARK(BM_Add)->RangeMultiplier(10)->Range(1000, max_size);
+BENCHMARK(BM_AddDuplicate)->RangeMultiplier(10)->Range(1000, max_size);
+BENCHMARK_CAPTURE(BM_AddHalfDuplicates, exceptions, false)->RangeMultiplier(10)->Range(1000, max_size);
+BENCHMARK_CAPTURE(BM_AddHalfDuplicates, status, true)->RangeMultiplier(10)->Range(1000, max_size);
+BENCHMARK(BM_Remove)->RangeMultiplier(10)->Range(1000, max_remove_size);
+BENCHMARK_CAPTURE(BM_RemoveMissing, exceptions, false)->RangeMultiplier(10)->Range(1000, max_size);
+BENCHMARK_CAPTURE(BM_RemoveMissing, status, true)->RangeMultiplier(10)->Range(1000, max_size);
+BENCHMARK(BM_Find)->RangeMultiplier(10)->Range(1000, max_size);
+BENCHMARK(BM_FindExactMissing)->RangeMultiplier(10)->Range(1000, max_size);
+BENCHMARK(BM_CompressedFind)->RangeMultiplier(10)->Range(1000, max_size);
+BENCHMARK(BM_SortedByFirstName)->RangeMultiplier(10)->Range(1000, max_size)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CompressedSortedByFirstName)->RangeMultiplier(10)->Range(1000, max_size)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_SortedByFirstNameAsyncFirstChunk)->RangeMultiplier(10)->Range(1000, max_size);
+BENCHMARK(BM_SortedByLastName)->RangeMultiplier(10)->Range(1000, max_size)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Plus)->RangeMultiplier(10)->Range(1000, max_size)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Minus)->RangeMultiplier(10)->Range(1000, max_size)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_BuildBook, default_heap, default_resource)->RangeMultiplier(10)->Range(1000, max_size)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_BuildBook, pool, pool_resource)->RangeMultiplier(10)->Range(1000, max_size)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_BuildBook, monotonic, monotonic_resource)->RangeMultiplier(10)->Range(1000, max_size)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_MixedBatch, individual, false)->RangeMultiplier(10)->Range(1000, max_individual_batch_size)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_MixedBatch, transaction, true)->RangeMultiplier(10)->Range(1000, max_size)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_BuildBookPolicy, LastNameIndexPolicy)->RangeMultiplier(10)->Range(1000, max_size)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_BuildBookPolicy, DefaultIndexPolicy)->RangeMultiplier(10)->Range(1000, max_size)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_BuildBookPolicy, FullIndexPolicy)->RangeMultiplier(10)->Range(1000, max_size)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_FindArena)->RangeMultiplier(10)->Range(1000, max_size);
+BENCHMARK_CAPTURE(BM_SetOperationScaling, union, SetOperation::Union)->ArgsProduct({ { max_size }, { 1, 2, 4, 8, 16 } })->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_SetOperationScaling, difference, SetOperation::Difference)->ArgsProduct({ { max_size }, { 1, 2, 4, 8, 16 } })->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_SetOperationScaling, intersection, SetOperation::Intersection)->ArgsProduct({ { max_size }, { 1, 2, 4, 8, 16 } })->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "address_book.h"
+
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cstdint>
+#include <cctype>
+#include <cmath>
+
+/*
+* Synthetic data generators for the address book benchmarks
+*
+* Real names are heavily skewed (lots of people are called "John Smith", very few are called "Phoenix Bond") so names
+* are drawn from a fixed pool with a Zipfian distribution. Phone numbers use a handful of realistic formats and are
+* unique per entry so every generated entry can be added to an address book.
+*/
+namespace bench_data
+{
+	/// Draws ranks in [0, n) where rank k has a probability proportional to 1 / (k + 1)^s
+	class ZipfianDistribution
+	{
+		// Cumulative probability of every rank
+		std::vector<double> cdf;
+
+	public:
+		ZipfianDistribution(size_t n, double s)
+		{
+			cdf.reserve(n);
+			double total = 0;
+			for (size_t k = 0; k < n; k++) {
+				total += 1.0 / std::pow(static_cast<double>(k + 1), s);
+				cdf.push_back(total);
+			}
+			for (double& p : cdf) {
+				p /= total;
+			}
+		}
+
+		template <typename Generator>
+		size_t operator()(Generator& rng)
+		{
+			double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+			size_t rank = std::lower_bound(cdf.begin(), cdf.end(), u) - cdf.begin();
+			return std::min(rank, cdf.size() - 1);
+		}
+	};
+
+
+	/// Make a pool of pronounceable, capitalised names by gluing syllables together
+	inline std::vector<std::string> makeNamePool(size_t count, uint64_t seed)
+	{
+		static const char* syllables[] = {
+			"ja", "de", "son", "mi", "la", "ri", "an", "el", "to", "ha", "mon", "sa", "ly", "bo", "nd", "gra",
+			"ham", "pa", "rk", "ul", "ph", "oe", "nix", "ad", "ria", "na", "za", "ke", "ith", "wen", "dy", "ro"
+		};
+		const size_t syllable_count = sizeof(syllables) / sizeof(syllables[0]);
+
+		std::mt19937_64 rng(seed);
+		std::vector<std::string> names;
+		names.reserve(count);
+
+		// Spell out the name index as a base-N number of syllables so names are (almost always) distinct, behind a random
+		// syllable so the pool doesn't look alphabetical
+		for (size_t i = 0; i < count; i++) {
+			std::string name = syllables[rng() % syllable_count];
+			for (size_t n = i; ; n /= syllable_count) {
+				name += syllables[n % syllable_count];
+				if (n < syllable_count) {
+					break;
+				}
+			}
+			name[0] = static_cast<char>(::toupper(name[0]));
+			names.push_back(name);
+		}
+
+		// Shuffle so the most popular (lowest rank) names are spread through the alphabet
+		std::shuffle(names.begin(), names.end(), rng);
+		return names;
+	}
+
+
+	/*
+	* Make a phone number in one of a few realistic formats
+	*
+	* The 10 variable digits come from unique so different values of unique always give different phone numbers.
+	*/
+	inline std::string makePhoneNumber(uint64_t unique, size_t format)
+	{
+		std::string digits = std::to_string(unique % 10000000000ULL);
+		digits.insert(0, 10 - digits.size(), '0');
+
+		switch (format % 3) {
+		case 0: // UK mobile with an extra digit, e.g. +44 7700 9002971
+			return "+44 7" + digits.substr(0, 3) + " " + digits.substr(3, 6) + digits.substr(9);
+		case 1: // UK landline, e.g. 0161 496 0311
+			return "0" + digits.substr(0, 3) + " " + digits.substr(3, 3) + " " + digits.substr(6);
+		default: // US, e.g. (739) 391-4868
+			return "(" + digits.substr(0, 3) + ") " + digits.substr(3, 3) + "-" + digits.substr(6);
+		}
+	}
+
+
+	/*
+	* Make count distinct entries with Zipfian first and last names
+	*
+	* The same seed always gives the same entries.
+	*/
+	inline std::vector<AddressBook::Entry> makeEntries(size_t count, uint64_t seed = 42)
+	{
+		static const std::vector<std::string> first_names = makeNamePool(2000, 1);
+		static const std::vector<std::string> last_names = makeNamePool(10000, 2);
+
+		std::mt19937_64 rng(seed);
+		ZipfianDistribution first_name_rank(first_names.size(), 1.0);
+		ZipfianDistribution last_name_rank(last_names.size(), 1.0);
+
+		std::vector<AddressBook::Entry> entries;
+		entries.reserve(count);
+		for (size_t i = 0; i < count; i++) {
+			// Multiplying by a number coprime to 10 is a bijection mod 10^10 on [0, 10^10) so every phone number is unique
+			uint64_t unique = (i + seed * 1000003ULL) * 2654435761ULL % 10000000000ULL;
+			entries.push_back({ first_names[first_name_rank(rng)], last_names[last_name_rank(rng)],
+				makePhoneNumber(unique, rng()) });
+		}
+		return entries;
+	}
+}
@@ -0,0 +1,34 @@
+#include "include/address_book_policies.h"
+
+
+void AccentStrippingCaseFolding::fold(std::pmr::string& key)
+{
+	// Plain letter for each of the 32 letters U+00C0 to U+00DF (upper case) and U+00E0 to U+00FF (lower case), which
+	// are encoded as 0xC3 followed by 0x80 to 0xBF. 0 means there is no plain letter.
+	static constexpr char stripped[33] = "aaaaaa\0ceeeeiiiidnooooo\0ouuuuy\0\0";
+
+	// Folding only ever shortens the key so it can be done in place
+	size_t out = 0;
+	for (size_t in = 0; in < key.size(); in++) {
+		unsigned char c = static_cast<unsigned char>(key[in]);
+		unsigned char next = in + 1 < key.size() ? static_cast<unsigned char>(key[in + 1]) : 0;
+
+		if (c != 0xC3 || next < 0x80 || next > 0xBF) {
+			key[out++] = static_cast<char>(::tolower(c));
+			continue;
+		}
+
+		in++;
+		char letter = next == 0xBF ? 'y' : stripped[(next - 0x80) & 0x1F];
+		if (letter != '\0') {
+			key[out++] = letter;
+			continue;
+		}
+
+		// No plain letter, lower case it unless it isn't a letter (multiplication and division signs) or has no upper
+		// case (sharp s)
+		key[out++] = static_cast<char>(c);
+		key[out++] = static_cast<char>(next < 0xA0 && next != 0x97 && next != 0x9F ? next + 0x20 : next);
+	}
+	key.resize(out);
+}
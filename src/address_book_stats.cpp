@@ -0,0 +1,143 @@
+#include "include/address_book_stats.h"
+
+#include <bit>
+#include <algorithm>
+
+
+const char* operationName(AddressBookOperation operation)
+{
+	switch (operation) {
+	case AddressBookOperation::Add: return "add";
+	case AddressBookOperation::AddDuplicateCheck: return "add_duplicate_check";
+	case AddressBookOperation::Remove: return "remove";
+	case AddressBookOperation::RebuildMaps: return "rebuild_maps";
+	case AddressBookOperation::Find: return "find";
+	case AddressBookOperation::SortedByFirstName: return "sorted_by_first_name";
+	case AddressBookOperation::SortedByLastName: return "sorted_by_last_name";
+	case AddressBookOperation::Commit: return "commit";
+	case AddressBookOperation::Union: return "union";
+	case AddressBookOperation::Difference: return "difference";
+	case AddressBookOperation::Intersection: return "intersection";
+	default: return "unknown";
+	}
+}
+
+
+size_t LatencyHistogram::bucketIndex(uint64_t ns)
+{
+	// Small values get a bucket each
+	if (ns < sub_bucket_count) {
+		return static_cast<size_t>(ns);
+	}
+
+	// Clamp anything too slow into the last bucket
+	uint64_t exponent = std::bit_width(ns) - 1;
+	if (exponent > max_exponent) {
+		return bucket_count - 1;
+	}
+
+	// The sub bucket is made of the bits right below the highest set bit
+	uint64_t shift = exponent - sub_bucket_bits;
+	uint64_t sub_bucket = (ns >> shift) - sub_bucket_count;
+	return static_cast<size_t>(sub_bucket_count + shift * sub_bucket_count + sub_bucket);
+}
+
+
+uint64_t LatencyHistogram::bucketLowerBound(size_t index)
+{
+	if (index < sub_bucket_count) {
+		return index;
+	}
+
+	uint64_t shift = (index - sub_bucket_count) / sub_bucket_count;
+	uint64_t sub_bucket = (index - sub_bucket_count) % sub_bucket_count;
+	return (sub_bucket_count + sub_bucket) << shift;
+}
+
+
+void LatencyHistogram::record(uint64_t ns)
+{
+	counts[bucketIndex(ns)]++;
+	total_count++;
+	total_ns += ns;
+	min_ns = std::min(min_ns, ns);
+	max_ns = std::max(max_ns, ns);
+}
+
+
+uint64_t LatencyHistogram::percentile(double fraction) const
+{
+	if (total_count == 0) {
+		return 0;
+	}
+
+	// Rank of the value we are looking for (1 based)
+	uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(fraction * total_count + 0.5));
+
+	// Walk the buckets until we've seen rank values
+	uint64_t seen = 0;
+	for (size_t i = 0; i < counts.size(); i++) {
+		seen += counts[i];
+		if (seen >= rank) {
+			return std::min(bucketLowerBound(i), max_ns);
+		}
+	}
+	return max_ns;
+}
+
+
+void AddressBookStats::writeText(std::ostream& os) const
+{
+	os << "entries: " << entries << "\n";
+	os << "first_name_keys: " << first_name_keys << " (largest bucket " << largest_first_name_bucket << ")\n";
+	os << "last_name_keys: " << last_name_keys << " (largest bucket " << largest_last_name_bucket << ")\n";
+	os << "phone_keys: " << phone_keys << "\n";
+	os << "full_text_keys: " << full_text_keys << "\n";
+	os << "find_cache_size: " << find_cache_size << "\n";
+
+	if (!enabled) {
+		os << "operations: instrumentation disabled (build with ADDRESSBOOK_ENABLE_STATS)\n";
+		return;
+	}
+
+	for (size_t i = 0; i < operations.size(); i++) {
+		const OperationStats& op = operations[i];
+		os << operationName(static_cast<AddressBookOperation>(i)) << ": calls=" << op.calls
+			<< " mean_ns=" << static_cast<uint64_t>(op.latency.mean())
+			<< " p50_ns=" << op.latency.percentile(0.5)
+			<< " p99_ns=" << op.latency.percentile(0.99)
+			<< " max_ns=" << op.latency.max() << "\n";
+	}
+}
+
+
+void AddressBookStats::writeJson(std::ostream& os) const
+{
+	os << "{\"enabled\":" << (enabled ? "true" : "false")
+		<< ",\"entries\":" << entries
+		<< ",\"first_name_keys\":" << first_name_keys
+		<< ",\"last_name_keys\":" << last_name_keys
+		<< ",\"largest_first_name_bucket\":" << largest_first_name_bucket
+		<< ",\"largest_last_name_bucket\":" << largest_last_name_bucket
+		<< ",\"phone_keys\":" << phone_keys
+		<< ",\"full_text_keys\":" << full_text_keys
+		<< ",\"find_cache_size\":" << find_cache_size
+		<< ",\"operations\":{";
+
+	for (size_t i = 0; i < operations.size(); i++) {
+		const OperationStats& op = operations[i];
+		if (i != 0) {
+			os << ",";
+		}
+		os << "\"" << operationName(static_cast<AddressBookOperation>(i)) << "\":{"
+			<< "\"calls\":" << op.calls
+			<< ",\"mean_ns\":" << static_cast<uint64_t>(op.latency.mean())
+			<< ",\"min_ns\":" << op.latency.min()
+			<< ",\"p50_ns\":" << op.latency.percentile(0.5)
+			<< ",\"p90_ns\":" << op.latency.percentile(0.9)
+			<< ",\"p99_ns\":" << op.latency.percentile(0.99)
+			<< ",\"max_ns\":" << op.latency.max() << "}";
+	}
+
+	os << "}}";
+}
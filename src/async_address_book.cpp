@@ -0,0 +1,119 @@
+#include "include/async_address_book.h"
+
+#include <stdexcept>
+#include <utility>
+
+
+AsyncAddressBook::AsyncAddressBook(AddressBook& book, size_t worker_count) : book(book), queue(worker_count)
+{
+}
+
+
+Task<std::vector<AddressBook::Entry>> AsyncAddressBook::findAsync(std::string prefix)
+{
+	// Move onto a worker, the caller is resumed once the results are ready
+	co_await queue.schedule();
+
+	std::lock_guard<std::mutex> lock(mutex);
+	co_return book.find(prefix);
+}
+
+
+AsyncGenerator<std::vector<AddressBook::Entry>> AsyncAddressBook::sortedByFirstNameAsync(size_t chunk_size)
+{
+	// Checked here rather than in the generator so the caller gets the exception straight away
+	if (chunk_size == 0) {
+		throw std::invalid_argument("Chunk size must be at least 1");
+	}
+	return listAsync(&AddressBook::first_name_map, chunk_size);
+}
+
+
+AsyncGenerator<std::vector<AddressBook::Entry>> AsyncAddressBook::sortedByLastNameAsync(size_t chunk_size)
+{
+	if (chunk_size == 0) {
+		throw std::invalid_argument("Chunk size must be at least 1");
+	}
+	return listAsync(&AddressBook::last_name_map, chunk_size);
+}
+
+
+AsyncGenerator<std::vector<AddressBook::Entry>> AsyncAddressBook::listAsync(NameMap AddressBook::* names,
+	size_t chunk_size)
+{
+	// Where the next chunk starts: a key of the map and how many of that key's entries were already listed
+	// The empty key is the lowest possible key so the first chunk starts at the beginning of the map
+	std::pmr::string next_key;
+	size_t next_position = 0;
+
+	while (true) {
+		// Every chunk is its own job so queries queued meanwhile get a turn
+		co_await queue.schedule();
+
+		std::vector<Entry> chunk;
+		bool finished;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			const NameMap& map = book.*names;
+
+			// Find the key again rather than keeping an iterator, the map may have changed since the last chunk
+			// If the key is gone carry on from the key after it
+			auto it = map.lower_bound(next_key);
+			size_t position = it != map.end() && it->first == next_key ? next_position : 0;
+
+			chunk.reserve(chunk_size);
+			while (it != map.end() && chunk.size() < chunk_size) {
+				const std::pmr::vector<size_t>& indices = it->second;
+				while (position < indices.size() && chunk.size() < chunk_size) {
+					chunk.push_back(book.entries.at(indices.at(position)).toEntry());
+					position++;
+				}
+				if (position >= indices.size()) {
+					it++;
+					position = 0;
+				}
+			}
+
+			finished = it == map.end();
+			if (!finished) {
+				next_key = it->first;
+				next_position = position;
+			}
+		}
+
+		if (!chunk.empty()) {
+			co_yield std::move(chunk);
+		}
+		if (finished) {
+			co_return;
+		}
+	}
+}
+
+
+void AsyncAddressBook::add(const Entry& person)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	book.add(person);
+}
+
+
+void AsyncAddressBook::remove(const Entry& person)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	book.remove(person);
+}
+
+
+AddressBook::Status AsyncAddressBook::tryAdd(const Entry& person)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return book.tryAdd(person);
+}
+
+
+AddressBook::Status AsyncAddressBook::tryRemove(const Entry& person)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	return book.tryRemove(person);
+}
@@ -0,0 +1,177 @@
+#include "include/autocomplete_session.h"
+
+#include <algorithm>
+#include <bit>
+#include <iterator>
+#include <string_view>
+
+
+/*
+* Return an iterator to the first key in the map that does not start with prefix and is greater than it
+*
+* This is the lower bound of the smallest string that is greater than every string starting with prefix, found by
+* dropping any trailing '\xff' characters and incrementing the last remaining character.
+*/
+template <typename NameMap>
+static typename NameMap::const_iterator prefixEnd(const NameMap& map, std::pmr::string prefix)
+{
+	while (!prefix.empty() && static_cast<unsigned char>(prefix.back()) == 0xff) {
+		prefix.pop_back();
+	}
+
+	// Every key starts with the prefix
+	if (prefix.empty()) {
+		return map.end();
+	}
+
+	prefix.back() = static_cast<char>(static_cast<unsigned char>(prefix.back()) + 1);
+	return map.lower_bound(prefix);
+}
+
+
+/*
+* Narrow [begin, end), whose keys all start with prefix less its last character, to the keys that start with prefix
+*
+* The matching keys are a run inside the range, so the bounds are walked in from both ends and a step costs one key
+* dropped from the range. A walk that would cost more than a map lookup (log2 of the map size) gives up and looks the
+* bound up in the whole map instead.
+*/
+template <typename NameMap>
+static void narrowRange(const NameMap& map, typename NameMap::const_iterator& begin,
+	typename NameMap::const_iterator& end, std::string_view prefix)
+{
+	const size_t max_steps = std::bit_width(map.size());
+
+	// Keys before the run are less than the prefix
+	size_t steps = 0;
+	while (begin != end && std::string_view(begin->first) < prefix) {
+		if (++steps > max_steps) {
+			begin = map.lower_bound(std::pmr::string(prefix));
+			break;
+		}
+		begin++;
+	}
+
+	// Keys after the run are greater than the prefix and don't start with it
+	steps = 0;
+	while (end != begin && !std::string_view(std::prev(end)->first).starts_with(prefix)) {
+		if (++steps > max_steps) {
+			end = prefixEnd(map, std::pmr::string(prefix));
+			break;
+		}
+		end--;
+	}
+}
+
+
+AutocompleteSession::AutocompleteSession(const AddressBook& book, size_t max_suggestions)
+	: book(book), max_suggestions(max_suggestions), synced_version(book.version()),
+	synced_index_generation(book.index_generation)
+{
+	ranges.push_back({ book.first_name_map.begin(), book.first_name_map.end(),
+		book.last_name_map.begin(), book.last_name_map.end() });
+}
+
+
+AutocompleteSession::Range AutocompleteSession::narrow(size_t length) const
+{
+	const Range& previous = ranges.at(length - 1);
+
+	// Nothing matched the shorter prefix so nothing can match the longer one either
+	if (previous.first_name_begin == previous.first_name_end && previous.last_name_begin == previous.last_name_end) {
+		return previous;
+	}
+
+	std::string_view prefix(prefix_lower.data(), length);
+
+	Range range = previous;
+	narrowRange(book.first_name_map, range.first_name_begin, range.first_name_end, prefix);
+	narrowRange(book.last_name_map, range.last_name_begin, range.last_name_end, prefix);
+	return range;
+}
+
+
+void AutocompleteSession::resyncIfChanged()
+{
+	if (synced_version == book.version() && synced_index_generation == book.index_generation) {
+		return;
+	}
+
+	// The maps changed under us (and may have been rebuilt) so none of the ranges can be trusted
+	ranges.clear();
+	ranges.push_back({ book.first_name_map.begin(), book.first_name_map.end(),
+		book.last_name_map.begin(), book.last_name_map.end() });
+
+	for (size_t length = 1; length <= prefix_lower.size(); length++) {
+		ranges.push_back(narrow(length));
+	}
+
+	synced_version = book.version();
+	synced_index_generation = book.index_generation;
+}
+
+
+void AutocompleteSession::type(const std::string& text)
+{
+	resyncIfChanged();
+
+	// Fold the text the same way the address book folds its keys
+	std::pmr::string folded(text.begin(), text.end());
+	DefaultIndexPolicy::case_folding::fold(folded);
+
+	for (char c : folded) {
+		prefix_lower.push_back(c);
+		ranges.push_back(narrow(prefix_lower.size()));
+	}
+}
+
+
+void AutocompleteSession::backspace()
+{
+	if (prefix_lower.empty()) {
+		return;
+	}
+
+	// The range for the shorter prefix is already on the stack
+	prefix_lower.pop_back();
+	ranges.pop_back();
+}
+
+
+std::vector<AutocompleteSession::Entry> AutocompleteSession::suggestions()
+{
+	resyncIfChanged();
+
+	// Output vector
+	std::vector<Entry> results;
+
+	// Indices of the entries already in the output vector
+	// There are at most max_suggestions of them so a linear search is fine
+	std::vector<size_t> found_indices;
+
+	const Range& range = ranges.back();
+	auto first_it = range.first_name_begin;
+	auto last_it = range.last_name_begin;
+
+	// Walk both ranges in key order (like the merge step of a merge sort) until we have enough suggestions
+	while (results.size() < max_suggestions && (first_it != range.first_name_end || last_it != range.last_name_end)) {
+		// Take from the first name range if its key comes first (first names win ties)
+		bool take_first = last_it == range.last_name_end
+			|| (first_it != range.first_name_end && first_it->first <= last_it->first);
+		auto& it = take_first ? first_it : last_it;
+
+		for (size_t index : it->second) {
+			if (results.size() == max_suggestions) {
+				break;
+			}
+			if (std::find(found_indices.begin(), found_indices.end(), index) == found_indices.end()) {
+				found_indices.push_back(index);
+				results.push_back(book.entries.at(index).toEntry());
+			}
+		}
+
+		it++;
+	}
+
+	return results;
+}
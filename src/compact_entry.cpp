@@ -0,0 +1,143 @@
+#include "include/compact_entry.h"
+#include "include/address_book.h"
+
+#include <functional>
+#include <stdexcept>
+#include <utility>
+
+
+CompactEntry::CompactEntry(const AddressBookEntry& entry, std::string_view first_name_folded,
+	std::string_view last_name_folded, const allocator_type& allocator)
+{
+	const std::string_view fields[FieldCount] = {
+		entry.first_name, entry.last_name, entry.phone_number, first_name_folded, last_name_folded
+	};
+
+	size_t total = 0;
+	for (int i = 0; i < FieldCount; i++) {
+		if (fields[i].size() > max_field_length) {
+			throw std::length_error("Entry field is too long");
+		}
+		lengths[i] = static_cast<uint16_t>(fields[i].size());
+		total += fields[i].size();
+	}
+
+	// Pack the fields inline if they fit, otherwise into a heap block
+	spilled = total > inline_capacity;
+	char* packed = storage;
+	if (spilled) {
+		packed = static_cast<char*>(allocator.resource()->allocate(total, alignof(char)));
+		setHeap(packed, allocator.resource());
+	}
+
+	for (const std::string_view& field : fields) {
+		std::memcpy(packed, field.data(), field.size());
+		packed += field.size();
+	}
+}
+
+
+CompactEntry::CompactEntry(CompactEntry&& other) noexcept
+{
+	// Taking over the heap block (if any) is just copying the pointer
+	copyBits(other);
+	other.spilled = false;
+}
+
+
+CompactEntry& CompactEntry::operator=(const CompactEntry& other)
+{
+	// Copy first so this is left untouched if the copy throws, a spilled entry keeps its resource
+	CompactEntry copy(other, spilled ? heapResource() : std::pmr::get_default_resource());
+	return *this = std::move(copy);
+}
+
+
+CompactEntry& CompactEntry::operator=(CompactEntry&& other)
+{
+	if (this != &other) {
+		// A spilled entry keeps its resource, so bytes spilled to another resource are copied rather than taken over
+		if (spilled && other.spilled && *heapResource() != *other.heapResource()) {
+			return *this = static_cast<const CompactEntry&>(other);
+		}
+		release();
+		copyBits(other);
+		other.spilled = false;
+	}
+	return *this;
+}
+
+
+void CompactEntry::copyBits(const CompactEntry& other) noexcept
+{
+	std::memcpy(lengths, other.lengths, sizeof(lengths));
+	spilled = other.spilled;
+	std::memcpy(storage, other.storage, sizeof(storage));
+}
+
+
+void CompactEntry::copyFrom(const CompactEntry& other, std::pmr::memory_resource* resource)
+{
+	// Allocate before copying anything so nothing is shared if the allocation throws
+	char* packed = nullptr;
+	if (other.spilled) {
+		packed = static_cast<char*>(resource->allocate(other.packedSize(), alignof(char)));
+		std::memcpy(packed, other.heapBytes(), other.packedSize());
+	}
+
+	copyBits(other);
+	if (packed != nullptr) {
+		setHeap(packed, resource);
+	}
+}
+
+
+void CompactEntry::takeFrom(CompactEntry& other, std::pmr::memory_resource* resource)
+{
+	if (other.spilled && *other.heapResource() != *resource) {
+		copyFrom(other, resource);
+		return;
+	}
+	copyBits(other);
+	other.spilled = false;
+}
+
+
+void CompactEntry::release() noexcept
+{
+	if (spilled) {
+		heapResource()->deallocate(heapBytes(), packedSize(), alignof(char));
+		spilled = false;
+	}
+}
+
+
+// Hash the fields one at a time so an entry can be fingerprinted straight from its strings, without packing it first
+// Every field hash is mixed into the running hash, so moving characters from one field to the next changes the result
+static uint64_t fieldsFingerprint(std::string_view first_name, std::string_view last_name, std::string_view phone_number)
+{
+	uint64_t hash = 0;
+	for (std::string_view field : { first_name, last_name, phone_number }) {
+		hash = (hash ^ std::hash<std::string_view>{}(field)) * 0x9e3779b97f4a7c15ULL;
+		hash ^= hash >> 29;
+	}
+	return hash;
+}
+
+
+uint64_t CompactEntry::fingerprint() const
+{
+	return fieldsFingerprint(firstName(), lastName(), phoneNumber());
+}
+
+
+uint64_t CompactEntry::fingerprint(const AddressBookEntry& entry)
+{
+	return fieldsFingerprint(entry.first_name, entry.last_name, entry.phone_number);
+}
+
+
+AddressBookEntry CompactEntry::toEntry() const
+{
+	return { std::string(firstName()), std::string(lastName()), std::string(phoneNumber()) };
+}
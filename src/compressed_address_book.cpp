@@ -0,0 +1,379 @@
+#include "include/compressed_address_book.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+
+// Append a LEB128 varint
+static void writeVarint(std::vector<char>& data, size_t value)
+{
+	while (value >= 0x80) {
+		data.push_back(static_cast<char>((value & 0x7F) | 0x80));
+		value >>= 7;
+	}
+	data.push_back(static_cast<char>(value));
+}
+
+
+// Read a LEB128 varint at position, moving position past it
+static size_t readVarint(const std::vector<char>& data, size_t& position)
+{
+	size_t value = 0;
+	for (size_t shift = 0;; shift += 7) {
+		unsigned char byte = static_cast<unsigned char>(data[position++]);
+		value |= size_t(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0) {
+			return value;
+		}
+	}
+}
+
+
+// Fold a search prefix the way AddressBook folds its keys
+static std::string foldName(std::string_view name)
+{
+	std::pmr::string folded(name);
+	DefaultIndexPolicy::case_folding::fold(folded);
+	return std::string(folded);
+}
+
+
+FrontCodedDictionary::FrontCodedDictionary(const std::vector<std::string_view>& strings) : count(strings.size())
+{
+	block_offsets.reserve((count + block_size - 1) / block_size);
+
+	std::string_view previous;
+	for (size_t i = 0; i < count; i++) {
+		std::string_view current = strings[i];
+
+		// The first string of a block is stored whole so a block can be decoded on its own
+		size_t shared = 0;
+		if (i % block_size == 0) {
+			if (data.size() > std::numeric_limits<uint32_t>::max()) {
+				throw std::length_error("Dictionary is too large");
+			}
+			block_offsets.push_back(static_cast<uint32_t>(data.size()));
+		}
+		else {
+			size_t limit = std::min(previous.size(), current.size());
+			while (shared < limit && previous[shared] == current[shared]) {
+				shared++;
+			}
+		}
+
+		writeVarint(data, shared);
+		writeVarint(data, current.size() - shared);
+		data.insert(data.end(), current.begin() + shared, current.end());
+		previous = current;
+	}
+	data.shrink_to_fit();
+}
+
+
+std::string FrontCodedDictionary::at(size_t id) const
+{
+	if (id >= count) {
+		throw std::out_of_range("Dictionary id out of range");
+	}
+
+	// Decode the block from its first string up to id
+	std::string result;
+	size_t position = block_offsets[id / block_size];
+	for (size_t i = id / block_size * block_size; i <= id; i++) {
+		size_t shared = readVarint(data, position);
+		size_t suffix = readVarint(data, position);
+		result.resize(shared);
+		result.append(data.data() + position, suffix);
+		position += suffix;
+	}
+	return result;
+}
+
+
+std::string_view FrontCodedDictionary::blockHead(size_t block) const
+{
+	size_t position = block_offsets[block];
+	readVarint(data, position);
+	size_t size = readVarint(data, position);
+	return std::string_view(data.data() + position, size);
+}
+
+
+size_t FrontCodedDictionary::lowerBound(std::string_view value) const
+{
+	// Binary search for the first block whose first string is greater than value, the answer is in the block before it
+	size_t block = 0;
+	size_t high = block_offsets.size();
+	while (block < high) {
+		size_t middle = block + (high - block) / 2;
+		if (blockHead(middle) <= value) {
+			block = middle + 1;
+		}
+		else {
+			high = middle;
+		}
+	}
+	if (block == 0) {
+		return 0;
+	}
+
+	// Decode the block until a string is not less than value
+	std::string current;
+	size_t position = block_offsets[block - 1];
+	size_t end = std::min(count, block * block_size);
+	for (size_t id = (block - 1) * block_size; id < end; id++) {
+		size_t shared = readVarint(data, position);
+		size_t suffix = readVarint(data, position);
+		current.resize(shared);
+		current.append(data.data() + position, suffix);
+		position += suffix;
+		if (current >= value) {
+			return id;
+		}
+	}
+	return end;
+}
+
+
+void PackedPhoneNumbers::push_back(std::string_view phone_number)
+{
+	bool packable = std::all_of(phone_number.begin(), phone_number.end(),
+		[](char c) { return alphabet.find(c) != std::string_view::npos; });
+	if (!packable) {
+		offsets.push_back(static_cast<uint32_t>(unpacked.size()) | unpacked_flag);
+		unpacked.emplace_back(phone_number);
+		return;
+	}
+
+	if (nibbles.size() >= unpacked_flag) {
+		throw std::length_error("Too many phone numbers to pack");
+	}
+	offsets.push_back(static_cast<uint32_t>(nibbles.size()));
+
+	// Two characters per byte, low nibble first, ending with a terminator (which may share the last byte)
+	for (size_t i = 0; i <= phone_number.size(); i += 2) {
+		uint8_t low = i < phone_number.size() ? static_cast<uint8_t>(alphabet.find(phone_number[i])) : terminator;
+		uint8_t high = i + 1 < phone_number.size() ? static_cast<uint8_t>(alphabet.find(phone_number[i + 1]))
+			: i + 1 == phone_number.size() ? terminator : 0;
+		nibbles.push_back(static_cast<uint8_t>(low | high << 4));
+	}
+}
+
+
+std::string PackedPhoneNumbers::at(size_t index) const
+{
+	uint32_t offset = offsets.at(index);
+	if (offset & unpacked_flag) {
+		return unpacked.at(offset & ~unpacked_flag);
+	}
+
+	std::string result;
+	for (size_t position = offset;; position++) {
+		for (uint8_t code : { static_cast<uint8_t>(nibbles[position] & 0xF), static_cast<uint8_t>(nibbles[position] >> 4) }) {
+			if (code == terminator) {
+				return result;
+			}
+			result.push_back(alphabet[code]);
+		}
+	}
+}
+
+
+size_t PackedPhoneNumbers::memoryUsage() const
+{
+	size_t bytes = nibbles.capacity() + offsets.capacity() * sizeof(uint32_t) + unpacked.capacity() * sizeof(std::string);
+	for (const std::string& number : unpacked) {
+		// Only count the heap block of numbers too long for the small string buffer
+		if (number.capacity() > std::string().capacity()) {
+			bytes += number.capacity() + 1;
+		}
+	}
+	return bytes;
+}
+
+
+std::pair<size_t, size_t> CompressedAddressBook::NameColumn::prefixRange(const std::string& prefix_lower) const
+{
+	size_t begin = keys.lowerBound(prefix_lower);
+
+	// The keys starting with the prefix end at the smallest string greater than all of them, found by dropping any
+	// trailing '\xff' characters and incrementing the last remaining character (see AutocompleteSession)
+	std::string prefix_end = prefix_lower;
+	while (!prefix_end.empty() && static_cast<unsigned char>(prefix_end.back()) == 0xff) {
+		prefix_end.pop_back();
+	}
+	if (prefix_end.empty()) {
+		return { begin, keyCount() };
+	}
+	prefix_end.back() = static_cast<char>(static_cast<unsigned char>(prefix_end.back()) + 1);
+	return { begin, keys.lowerBound(prefix_end) };
+}
+
+
+size_t CompressedAddressBook::NameColumn::memoryUsage() const
+{
+	return names.memoryUsage() + keys.memoryUsage() + (key_starts.capacity() + key_offsets.capacity() + key_entries.capacity()
+		+ entry_names.capacity()) * sizeof(uint32_t);
+}
+
+
+CompressedAddressBook::NameColumn CompressedAddressBook::buildColumn(const std::vector<std::string_view>& names,
+	const std::vector<std::string_view>& names_lower)
+{
+	NameColumn column;
+
+	// Every distinct name, sorted by folded key so the names of a key are next to each other
+	std::vector<std::pair<std::string_view, std::string_view>> distinct;
+	distinct.reserve(names.size());
+	for (size_t i = 0; i < names.size(); i++) {
+		distinct.emplace_back(names_lower[i], names[i]);
+	}
+	std::sort(distinct.begin(), distinct.end());
+	distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+
+	// Note: The same name always folds to the same key so names are unique across keys too
+	std::vector<std::string_view> sorted_names;
+	std::vector<std::string_view> sorted_keys;
+	sorted_names.reserve(distinct.size());
+	for (size_t id = 0; id < distinct.size(); id++) {
+		if (id == 0 || distinct[id].first != distinct[id - 1].first) {
+			column.key_starts.push_back(static_cast<uint32_t>(id));
+			sorted_keys.push_back(distinct[id].first);
+		}
+		sorted_names.push_back(distinct[id].second);
+	}
+	column.key_starts.push_back(static_cast<uint32_t>(distinct.size()));
+	column.names = FrontCodedDictionary(sorted_names);
+	column.keys = FrontCodedDictionary(sorted_keys);
+
+	// Name id of every entry, and the key it belongs to
+	std::vector<uint32_t> entry_keys(names.size());
+	column.entry_names.resize(names.size());
+	for (size_t i = 0; i < names.size(); i++) {
+		auto it = std::lower_bound(distinct.begin(), distinct.end(), std::make_pair(names_lower[i], names[i]));
+		uint32_t name_id = static_cast<uint32_t>(it - distinct.begin());
+		column.entry_names[i] = name_id;
+		entry_keys[i] = static_cast<uint32_t>(
+			std::upper_bound(column.key_starts.begin(), column.key_starts.end(), name_id) - column.key_starts.begin() - 1);
+	}
+
+	// Bucket the entries by key (a counting sort, so every key's entries stay in address book order)
+	column.key_offsets.assign(column.keyCount() + 1, 0);
+	for (uint32_t key : entry_keys) {
+		column.key_offsets[key + 1]++;
+	}
+	for (size_t key = 0; key < column.keyCount(); key++) {
+		column.key_offsets[key + 1] += column.key_offsets[key];
+	}
+	column.key_entries.resize(names.size());
+	std::vector<uint32_t> next(column.key_offsets.begin(), column.key_offsets.end() - 1);
+	for (size_t i = 0; i < names.size(); i++) {
+		column.key_entries[next[entry_keys[i]]++] = static_cast<uint32_t>(i);
+	}
+
+	column.key_starts.shrink_to_fit();
+	return column;
+}
+
+
+CompressedAddressBook::CompressedAddressBook(const AddressBook& book) : entry_count(book.entries.size())
+{
+	if (entry_count > std::numeric_limits<uint32_t>::max()) {
+		throw std::length_error("Address book is too large to compress");
+	}
+
+	// The entries keep their folded names so nothing has to be folded again
+	std::vector<std::string_view> names(entry_count);
+	std::vector<std::string_view> names_lower(entry_count);
+	for (size_t i = 0; i < entry_count; i++) {
+		names[i] = book.entries[i].firstName();
+		names_lower[i] = book.entries[i].firstNameFolded();
+	}
+	first_names = buildColumn(names, names_lower);
+
+	for (size_t i = 0; i < entry_count; i++) {
+		names[i] = book.entries[i].lastName();
+		names_lower[i] = book.entries[i].lastNameFolded();
+	}
+	last_names = buildColumn(names, names_lower);
+
+	for (size_t i = 0; i < entry_count; i++) {
+		phone_numbers.push_back(book.entries[i].phoneNumber());
+	}
+}
+
+
+CompressedAddressBook::Entry CompressedAddressBook::decode(size_t entry, DecodeCache& cache) const
+{
+	if (first_names.entry_names[entry] != cache.first_name_id) {
+		cache.first_name_id = first_names.entry_names[entry];
+		cache.first_name = first_names.names.at(cache.first_name_id);
+	}
+	if (last_names.entry_names[entry] != cache.last_name_id) {
+		cache.last_name_id = last_names.entry_names[entry];
+		cache.last_name = last_names.names.at(cache.last_name_id);
+	}
+	return { cache.first_name, cache.last_name, phone_numbers.at(entry) };
+}
+
+
+void CompressedAddressBook::collectPrefixMatches(const NameColumn& column, const std::string& prefix_lower,
+	std::pmr::vector<uint32_t>& results, std::pmr::unordered_set<uint32_t>& found)
+{
+	auto [begin, end] = column.prefixRange(prefix_lower);
+	for (size_t key = begin; key < end; key++) {
+		for (uint32_t i = column.key_offsets[key]; i < column.key_offsets[key + 1]; i++) {
+			if (found.insert(column.key_entries[i]).second) {
+				results.push_back(column.key_entries[i]);
+			}
+		}
+	}
+}
+
+
+std::vector<CompressedAddressBook::Entry> CompressedAddressBook::find(const std::string& prefix) const
+{
+	std::string prefix_lower = foldName(prefix);
+
+	// Scratch memory for the query, on the stack unless the query needs more than that
+	std::array<std::byte, 2048> scratch_buffer;
+	std::pmr::monotonic_buffer_resource scratch(scratch_buffer.data(), scratch_buffer.size());
+
+	// First name matches come first, then any last name matches that weren't already found
+	std::pmr::vector<uint32_t> matches(&scratch);
+	std::pmr::unordered_set<uint32_t> found(&scratch);
+	collectPrefixMatches(first_names, prefix_lower, matches, found);
+	collectPrefixMatches(last_names, prefix_lower, matches, found);
+
+	// Only the matches are decoded
+	std::vector<Entry> results;
+	results.reserve(matches.size());
+	DecodeCache cache;
+	for (uint32_t entry : matches) {
+		results.push_back(decode(entry, cache));
+	}
+	return results;
+}
+
+
+std::vector<CompressedAddressBook::Entry> CompressedAddressBook::listSorted(const NameColumn& column) const
+{
+	std::vector<Entry> results;
+	results.reserve(entry_count);
+	DecodeCache cache;
+	for (uint32_t entry : column.key_entries) {
+		results.push_back(decode(entry, cache));
+	}
+	return results;
+}
+
+
+size_t CompressedAddressBook::memoryUsage() const
+{
+	return first_names.memoryUsage() + last_names.memoryUsage() + phone_numbers.memoryUsage();
+}
@@ -0,0 +1,43 @@
+#include "include/counting_bloom_filter.h"
+
+#include <algorithm>
+
+
+CountingBloomFilter::CountingBloomFilter(size_t capacity, std::pmr::memory_resource* resource)
+	: blocks(std::max<size_t>(1, (capacity * counters_per_key + counters_per_block - 1) / counters_per_block), Block{},
+		resource), key_capacity(capacity)
+{
+}
+
+
+void CountingBloomFilter::insert(uint64_t hash)
+{
+	Block& key_block = block(hash);
+	for (size_t i = 0; i < hash_count; i++) {
+		size_t index = counter(hash, i);
+		if (get(key_block, index) != max_count) {
+			key_block.words[index / 16] += uint64_t(1) << (index % 16 * 4);
+		}
+	}
+}
+
+
+void CountingBloomFilter::erase(uint64_t hash)
+{
+	Block& key_block = block(hash);
+	for (size_t i = 0; i < hash_count; i++) {
+		size_t index = counter(hash, i);
+
+		// A saturated counter has lost track of how many keys share it so it is never decremented
+		uint64_t count = get(key_block, index);
+		if (count != 0 && count != max_count) {
+			key_block.words[index / 16] -= uint64_t(1) << (index % 16 * 4);
+		}
+	}
+}
+
+
+void CountingBloomFilter::clear()
+{
+	std::fill(blocks.begin(), blocks.end(), Block{});
+}
@@ -1,50 +1,402 @@
 #pragma once
 
+#include "address_book_stats.h"
+#include "address_book_policies.h"
+#include "compact_entry.h"
+#include "counting_bloom_filter.h"
+#include "work_stealing_pool.h"
+
 #include <string>
+#include <string_view>
 #include <vector>
 #include <ostream>
 #include <map>
+#include <list>
+#include <unordered_map>
+#include <unordered_set>
+#include <memory_resource>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <tuple>
+#include <functional>
+#include <initializer_list>
+
+/// A container for address book data
+struct AddressBookEntry
+{
+	std::string first_name;
+	std::string last_name;
+	std::string phone_number;
+
+	// Overload the equality operator so we can compare two entries
+	// This is useful for functions like std::find and std::remove
+	bool operator==(const AddressBookEntry& rhs);
+
+	friend bool operator==(const AddressBookEntry& lhs, const AddressBookEntry& rhs);
+
+	// Overload the inequality operator so we can compare two entries
+	// Added for completeness
+	friend bool operator!=(const AddressBookEntry& lhs, const AddressBookEntry& rhs);
+
+	// Overload the output operator so we can print an entry
+	// This is useful for debugging
+	friend std::ostream& operator<<(std::ostream& os, const AddressBookEntry& e);
+};
+
 
 /*
 * @brief A class to store address book data
 * 
 * This class stores address book data and provides methods to add, remove, and find entries
+*
+* The indexes it maintains, and how names are case folded, are chosen at compile time by Policy (see
+* address_book_policies.h) so unused indexes cost nothing. AddressBook is the default instantiation with first and last
+* name indexes.
+* Note: The member functions are defined in address_book_impl.h so any policy works, including one defined by the user.
+* The policies in address_book_policies.h are explicitly instantiated once in address_book.cpp.
 */
-class AddressBook
+template <typename Policy>
+class BasicAddressBook
 {
+	static_assert(Policy::first_name_index || Policy::last_name_index, "At least one of the name indexes must be enabled");
+
 public:
 	/// A container for address book data
-	struct Entry
+	using Entry = AddressBookEntry;
+
+	/// The kind of mutation recorded in the change feed
+	enum class ChangeType
+	{
+		Added,
+		Removed
+	};
+
+	/// A single mutation recorded in the change feed
+	struct Change
+	{
+		// The version of the address book right after this change was applied
+		uint64_t version;
+		ChangeType type;
+		Entry entry;
+	};
+
+	/// The outcome of tryAdd, tryRemove and Transaction::tryCommit
+	enum class Status
+	{
+		Ok,
+		// The entry to add has neither a first nor a last name
+		MissingName,
+		// The entry to add is already in the address book
+		AlreadyExists,
+		// The entry to remove isn't in the address book
+		NotFound,
+		// A name or the phone number is longer than CompactEntry::max_field_length (65535 bytes)
+		FieldTooLong
+	};
+
+	// Number of changes kept in the change feed when no capacity is given
+	static constexpr size_t default_change_feed_capacity = 1024;
+
+	/// How many changes the change feed keeps, a type of its own so BasicAddressBook(0) isn't mistaken for a resource
+	struct ChangeFeedCapacity
+	{
+		size_t value;
+	};
+
+	/*
+	* @brief A batch of adds and removes applied to an address book all at once
+	*
+	* Created by BasicAddressBook::begin. Mutations are queued in order and nothing happens to the address book until
+	* commit, which checks the whole batch first and then applies it with a single update of the indexes (no map
+	* rebuild per remove). If any mutation is invalid commit throws and the address book is left untouched.
+	* A transaction refers to its address book, which must outlive it. Like the address book it isn't thread safe.
+	*/
+	class Transaction
 	{
-		std::string first_name;
-		std::string last_name;
-		std::string phone_number;
+		BasicAddressBook& book;
+		std::vector<std::pair<ChangeType, Entry>> mutations;
 
-		// Overload the equality operator so we can compare two entries
-		// This is useful for functions like std::find and std::remove
-		bool operator==(const Entry& rhs);
+	public:
+		explicit Transaction(BasicAddressBook& book) : book(book) {}
 
-		friend bool operator==(const Entry& lhs, const Entry& rhs);
+		/// Queue adding a person (see BasicAddressBook::add)
+		void add(const Entry& person) { mutations.emplace_back(ChangeType::Added, person); }
 
-		// Overload the inequality operator so we can compare two entries
-		// Added for completeness
-		friend bool operator!=(const Entry& lhs, const Entry& rhs);
+		/// Queue removing a person (see BasicAddressBook::remove)
+		void remove(const Entry& person) { mutations.emplace_back(ChangeType::Removed, person); }
 
-		// Overload the output operator so we can print an entry
-		// This is useful for debugging
-		friend std::ostream& operator<<(std::ostream& os, const Entry& e);
+		/// Number of mutations queued
+		size_t size() const { return mutations.size(); }
+
+		/// Drop every queued mutation
+		void rollback() { mutations.clear(); }
+
+		/*
+		* @brief Apply the queued mutations to the address book
+		*
+		* The mutations are checked in the order they were queued, as if add and remove were called one after the other:
+		* an add fails if the entry has no name or already exists (in the address book or because of an earlier add in
+		* the batch), a remove fails if the entry doesn't exist at that point, and either fails if a field of the entry
+		* is longer than 65535 bytes. Only the net effect on each entry is
+		* applied and recorded in the change feed, e.g. adding and then removing a new entry changes nothing.
+		* The queue is emptied whether the commit succeeds or not, so the transaction can be reused.
+		*
+		* @throws std::invalid_argument if a mutation is invalid, nothing is applied
+		* @throws std::length_error if an entry has a field longer than 65535 bytes, nothing is applied
+		* @return void
+		*/
+		void commit() { throwIfFailed(tryCommit()); }
+
+		/*
+		* @brief Apply the queued mutations to the address book without throwing if one of them is invalid
+		*
+		* Same as commit but the first invalid mutation is reported in the returned status.
+		*
+		* @return AddressBook::Status Ok, or why the first invalid mutation failed (nothing is applied)
+		*/
+		[[nodiscard]] Status tryCommit()
+		{
+			std::vector<std::pair<ChangeType, Entry>> batch = std::move(mutations);
+			mutations.clear();
+			return book.applyBatch(batch);
+		}
+	};
+
+	/// Counters describing how well the find cache is doing
+	struct FindCacheStats
+	{
+		uint64_t hits;
+		uint64_t misses;
+		// Number of prefixes currently cached
+		size_t size;
+		// Maximum number of prefixes cached (0 means the cache is disabled)
+		size_t capacity;
 	};
 
 private:
+	// Autocomplete sessions and the chunked listings of the async front end walk the name maps directly, compressed
+	// snapshots read the entries with their folded names
+	friend class AutocompleteSession;
+	friend class AsyncAddressBook;
+	friend class CompressedAddressBook;
+
+	// Index into the entries vector meaning "no entry"
+	static constexpr size_t no_entry = static_cast<size_t>(-1);
+
+	// Memory resource everything the address book owns is allocated from
+	// Declared first so the containers below can be constructed with it
+	std::pmr::memory_resource* resource = std::pmr::get_default_resource();
+
 	// Vector to store all the entries
-	std::vector<Entry> entries;
+	// Entries are stored packed (see CompactEntry) along with their folded names and unpacked into Entry when returned
+	// Entries too long to fit in a CompactEntry spill to a block allocated from resource
+	std::pmr::vector<CompactEntry> entries{ resource };
+
+	// Fingerprint of every entry (see CompactEntry::fingerprint), fingerprints[i] belongs to entries[i]
+	// Worked out once when the entry is added. Looking for an entry compares these first so the entries themselves are
+	// only compared when the fingerprints match.
+	std::pmr::vector<uint64_t> fingerprints{ resource };
+
+	// Counting Bloom filters over the fingerprints of the entries and over the keys of the enabled name maps
+	// add, remove and findExact check them first so entries and names that aren't there are turned away without
+	// touching the maps. Rebuilt twice as big whenever the entries outgrow them.
+	CountingBloomFilter entry_filter{ 0, resource };
+	CountingBloomFilter name_filter{ 0, resource };
+
+	// Smallest number of entries the filters are sized for
+	static constexpr size_t min_filter_capacity = 64;
+
+	// Every entry puts one key in the name filter per enabled name map
+	static constexpr size_t names_per_entry = size_t{ Policy::first_name_index } + size_t{ Policy::last_name_index };
+
+	/*
+	* Method to make sure the filters are sized for at least entry_count entries, rebuilding them if they aren't
+	*/
+	void reserveFilters(size_t entry_count);
+
+	/*
+	* Methods to add the entry at index to the filters or take it out again
+	*/
+	void filterEntry(size_t index);
+	void unfilterEntry(size_t index);
+
+	/*
+	* Method to rebuild the filters from the entries on pool
+	*
+	* The hashes of chunks of entries are worked out in parallel and scattered by the slice of the filters they land in
+	* (see CountingBloomFilter::sliceOf), then every slice is filled by its own job.
+	*/
+	void refilterParallel(WorkStealingPool& pool);
+
+	/*
+	* Method to return the hash a folded name is kept under in the name filter
+	*/
+	static uint64_t nameHash(std::string_view name_lower) { return std::hash<std::string_view>{}(name_lower); }
 
 	// Maps to map first and last names to entries
 	// This is useful for sorting, and finding entries by first and last name
 	// Keys are first for the first_name_map and last names for the last_name_map
 	// Values are a vector of indices to entries in the entries vector
-	std::map<std::string, std::vector<size_t>> first_name_map;
-	std::map<std::string, std::vector<size_t>> last_name_map;
+	using NameMap = std::pmr::map<std::pmr::string, std::pmr::vector<size_t>>;
+
+	/// Stands in for an index the policy disables, takes no space and ignores the arguments a map would be given
+	struct DisabledIndex
+	{
+		DisabledIndex(std::pmr::memory_resource*) {}
+		DisabledIndex(const DisabledIndex&, std::pmr::memory_resource*) {}
+		DisabledIndex(const DisabledIndex&) = default;
+		DisabledIndex& operator=(const DisabledIndex&) = default;
+		void clear() {}
+	};
+
+	template <bool Enabled>
+	using Index = std::conditional_t<Enabled, NameMap, DisabledIndex>;
+
+	[[no_unique_address]] Index<Policy::first_name_index> first_name_map{ resource };
+	[[no_unique_address]] Index<Policy::last_name_index> last_name_map{ resource };
+
+	// Map of phone numbers (digits only) to entries
+	[[no_unique_address]] Index<Policy::phone_index> phone_map{ resource };
+
+	// Map of every word in the first and last names to entries, e.g. "Mary Ann" is indexed under "mary" and "ann"
+	[[no_unique_address]] Index<Policy::full_text_index> full_text_map{ resource };
+
+	/*
+	* Method to add an entry to every enabled index
+	*
+	* Keys are the case folded first and last names kept in the entry at index
+	*/
+	void indexEntry(size_t index);
+
+	/*
+	* Method to call visit(map, key) for every index key of the entry at index
+	*
+	* One call per enabled index (several for the full text index, one per distinct word). The keys are allocated from
+	* key_resource. Nothing is changed so several threads can visit entries at once if key_resource is thread safe.
+	*/
+	template <typename Visit>
+	void visitIndexKeys(size_t index, std::pmr::memory_resource* key_resource, Visit visit);
+
+	/// An index key of an entry waiting to be inserted into its map
+	struct IndexKey
+	{
+		NameMap* map;
+		std::pmr::string key;
+		size_t index;
+
+		/// Orders keys by map, then key, then entry
+		friend bool operator<(const IndexKey& lhs, const IndexKey& rhs)
+		{
+			return std::tie(lhs.map, lhs.key, lhs.index) < std::tie(rhs.map, rhs.key, rhs.index);
+		}
+	};
+
+	/*
+	* Method to insert keys (sorted, see IndexKey) into their maps
+	*
+	* Every key is inserted next to where the previous one went. The indices of the keys must be larger than the ones
+	* already in the maps.
+	*/
+	void mergeIndexKeys(std::span<IndexKey> keys);
+
+	// The set operations split the address books into this many partitions (by fingerprint) per thread of the pool,
+	// more partitions than threads so threads that finish early can steal the partitions of the others
+	static constexpr size_t partitions_per_thread = 4;
+
+	// Address books smaller than this are handled in a single partition, splitting them costs more than it saves
+	static constexpr size_t parallel_threshold = 4096;
+
+	/*
+	* Method to return how many partitions the set operations split entry_count entries into
+	*/
+	static size_t partitionCount(size_t entry_count, const WorkStealingPool& pool);
+
+	/*
+	* Method to work out which of our entries are also in other, one flag per entry
+	*
+	* The entries of both address books are split into partitions by fingerprint, equal entries always land in the same
+	* partition so every partition is matched on its own on pool, with a hash table of the other book's entries.
+	*/
+	std::vector<char> matchEntries(const BasicAddressBook& other, WorkStealingPool& pool) const;
+
+	/// Entries of an address book going into the result of a set operation
+	struct EntrySource
+	{
+		const BasicAddressBook* book;
+
+		// An entry is kept when its flag is keep_matched, every entry is kept when there are no flags
+		const std::vector<char>* matched;
+		bool keep_matched;
+
+		// Whether the kept entries are recorded as added (they are new to the result) rather than the others as removed
+		bool record_kept;
+	};
+
+	/*
+	* Method to replace the entries with the ones kept from sources (in order), then rebuild the filters and maps on pool
+	*
+	* Every source is split into chunks of consecutive entries. The chunks count the entries they keep in parallel, a
+	* prefix sum of the counts gives every chunk its slice of the new entries and fingerprints, and the chunks then copy
+	* their entries into their slices in parallel (when resource is thread safe, spilled entries allocate from it). The
+	* dropped or added entries are recorded as changes. A source may be this address book.
+	*/
+	void gatherEntries(std::initializer_list<EntrySource> sources, WorkStealingPool& pool);
+
+	/*
+	* Method to copy the version, change feed and settings but no entries, for the set operations to gather into
+	*/
+	BasicAddressBook copyWithoutEntries() const;
+
+	/*
+	* Method to return whether the address book's resource can be allocated from by several threads at once
+	*/
+	bool resourceIsThreadSafe() const { return *resource == *std::pmr::new_delete_resource(); }
+
+	/*
+	* Method to rebuild the maps, building them all at once on pool
+	*
+	* The index keys of chunks of entries are collected in parallel and scattered into ranges of keys, at splitters
+	* picked from a sample of every chunk. Every range is sorted on its own and, when resource is thread safe, builds its
+	* part of every map as a map of its own. std::map can't be filled by several threads so the nodes of the ranges are
+	* then moved into the maps in key order, which only relinks them (no allocations or copies). Otherwise the sorted
+	* ranges are inserted into the maps one after the other.
+	*/
+	void rebuildMapsParallel(WorkStealingPool& pool);
+
+	/*
+	* Method to return the index of the entry equal to compact (or no_entry if there isn't one)
+	*/
+	size_t locate(const CompactEntry& compact, uint64_t fingerprint);
+
+	/*
+	* Method to check and apply the mutations of a transaction, see Transaction::commit
+	*
+	* Removed entries are dropped by compacting the entries vector and renumbering the indices already in the maps in
+	* place. The keys of the added entries are sorted and merged into the maps in order, using the previous key as a
+	* hint, so the maps are updated once per batch rather than rebuilt.
+	*/
+	Status applyBatch(const std::vector<std::pair<ChangeType, Entry>>& mutations);
+
+	/*
+	* Method to throw the exception add, remove and commit have always thrown for a failed status
+	*/
+	static void throwIfFailed(Status status);
+
+	/*
+	* Method to return the name map used to look for an existing entry (the first name map unless it is disabled)
+	*
+	* Any entry is in both name maps so there is no need to look in both of them
+	*/
+	NameMap& primaryNameMap();
+
+	/*
+	* Method to find the indices of the entries whose key in map starts with the already folded prefix
+	*
+	* Entries already in found are skipped, every index returned is added to found.
+	*/
+	static void collectPrefixMatches(const NameMap& map, const std::pmr::string& prefix_lower,
+		std::pmr::vector<size_t>& results, std::pmr::unordered_set<size_t>& found);
 
 	/*
 	* Method to rebuild the maps
@@ -58,20 +410,108 @@ private:
 	*/
 	void rebuildMaps();
 
+	// Version of the address book, incremented by every entry added or removed
+	uint64_t current_version = 0;
+
+	// Incremented whenever the maps are cleared, rebuilt, assigned or have keys erased, which invalidates iterators
+	// into them even when the version doesn't change (e.g. a set operation that removes nothing)
+	uint64_t index_generation = 0;
+
+	// Ring buffer of the most recent changes
+	// Holds at most change_feed_capacity changes, once full change_feed_head points at the oldest change which is the
+	// next one to be overwritten
+	std::pmr::vector<Change> change_feed{ resource };
+	size_t change_feed_head = 0;
+	size_t change_feed_capacity = default_change_feed_capacity;
+
+	/*
+	* Method to record a change in the change feed
+	*
+	* Bumps the version and stores the change in the ring buffer, overwriting the oldest change if the buffer is full
+	*/
+	void recordChange(ChangeType type, const Entry& person);
+
+	// LRU cache of find results keyed by the lower case prefix
+	// The list holds the cached results, most recently used first. The unordered map points at the list node for each
+	// prefix so lookups don't have to walk the list.
+	// A capacity of 0 means the cache is disabled
+	using FindCacheList = std::pmr::list<std::pair<std::pmr::string, std::pmr::vector<Entry>>>;
+	FindCacheList find_cache_lru{ resource };
+	std::pmr::unordered_map<std::pmr::string, FindCacheList::iterator> find_cache_index{ resource };
+	size_t find_cache_capacity = 0;
+	uint64_t find_cache_hits = 0;
+	uint64_t find_cache_misses = 0;
+
+	/*
+	* Method to drop cached find results that a change to a name could affect
+	*
+	* A find result can only change if the prefix it was cached under is a prefix of the touched name, so only those
+	* prefixes (at most one per character of the name) are dropped.
+	*/
+	void invalidateFindCache(std::string_view name_lower);
+
+	/*
+	* Method to find the indices of the entries matching an already lower cased prefix without going through the cache
+	*
+	* The returned vector and any temporary memory used to remove duplicates come from scratch, so a request scoped
+	* arena can be used and thrown away as soon as the results have been copied out.
+	*/
+	std::pmr::vector<size_t> findIndices(const std::pmr::string& prefix_lower, std::pmr::memory_resource* scratch);
+
+	/*
+	* Method to find entries matching the prefix and write them to results, going through the cache if it is enabled
+	*/
+	template <typename Results>
+	void findInto(const std::string& prefix, Results& results, std::pmr::memory_resource* scratch);
+
+	// Call counts and latencies of the operations (does nothing and takes no space unless built with
+	// ADDRESSBOOK_ENABLE_STATS)
+	[[no_unique_address]] OperationRecorder operation_recorder;
+
 public:
 
 	// Default constructor
-	AddressBook() {}
+	BasicAddressBook() {}
+
+	/*
+	* @brief Construct an empty address book that allocates everything it owns from resource
+	*
+	* The entries vector, the maps (keys and index vectors), the change feed and the find cache all allocate from
+	* resource, e.g. a std::pmr::unsynchronized_pool_resource for a long lived address book. The resource must outlive
+	* the address book.
+	*
+	* @param resource The memory resource to allocate from
+	*/
+	explicit BasicAddressBook(std::pmr::memory_resource* resource) : resource(resource) {}
+
+	/*
+	* @brief Construct an empty address book that keeps the last change_feed_capacity changes
+	*
+	* e.g. BasicAddressBook(ChangeFeedCapacity{ 0 }) for an address book without a change feed.
+	*
+	* @param change_feed_capacity How many changes to keep for changesSince. 0 disables the change feed
+	* @param resource The memory resource to allocate from (the default resource if not given)
+	*/
+	explicit BasicAddressBook(ChangeFeedCapacity change_feed_capacity,
+		std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+		: resource(resource), change_feed_capacity(change_feed_capacity.value) {}
 
 	// Copy constructor
-	AddressBook(const AddressBook& ab) : entries(ab.entries), first_name_map(ab.first_name_map), last_name_map(ab.last_name_map) {};
+	// Like the std::pmr containers, the copy allocates from the default resource rather than the resource of ab
+	BasicAddressBook(const BasicAddressBook& ab) : entries(ab.entries, resource),
+		fingerprints(ab.fingerprints, resource), entry_filter(ab.entry_filter, resource),
+		name_filter(ab.name_filter, resource), first_name_map(ab.first_name_map, resource),
+		last_name_map(ab.last_name_map, resource), phone_map(ab.phone_map, resource),
+		full_text_map(ab.full_text_map, resource), current_version(ab.current_version), change_feed(ab.change_feed, resource),
+		change_feed_head(ab.change_feed_head), change_feed_capacity(ab.change_feed_capacity),
+		find_cache_capacity(ab.find_cache_capacity), operation_recorder(ab.operation_recorder) {};
 
 	// Copy assignment operator
-	AddressBook& operator=(const AddressBook& ab);
+	BasicAddressBook& operator=(const BasicAddressBook& ab);
 
 	// Move assignment operator
 	// Convenient for "AddressBook arithmetic"
-	AddressBook& operator=(AddressBook&& ab) noexcept;
+	BasicAddressBook& operator=(BasicAddressBook&& ab) noexcept;
 
 
 	/*
@@ -84,9 +524,10 @@ public:
 	* 
 	* This might be convenient if we want to combine two address books together rather than having to add each entry
 	* in a for loop
+	* Runs on the shared pool, see unionWith
 	*/
-	AddressBook operator+(const AddressBook& rhs);
-	friend AddressBook operator+(const AddressBook& lhs, const AddressBook& rhs);
+	BasicAddressBook operator+(const BasicAddressBook& rhs) { return unionWith(rhs); }
+	friend BasicAddressBook operator+(const BasicAddressBook& lhs, const BasicAddressBook& rhs) { return lhs.unionWith(rhs); }
 
 
 	/*
@@ -100,11 +541,62 @@ public:
 	* 
 	* Note: We are not using the remove method here because we don't want to rebuild the maps everytime an entry is removed
 	* that way we save some time and memory. We only rebuild the maps once at the end.
-	* But we are also not using the maps to find the entries to remove. Instead we are using std::remove_if and looping through
-	* the rhs entries vector to find the entries to remove. This is quite inefficient making this method quite expensive to call.
+	* The entries to remove are found and the maps rebuilt on the shared pool, see differenceWith.
+	*/
+	BasicAddressBook operator-(const BasicAddressBook& rhs);
+	friend BasicAddressBook operator-(const BasicAddressBook& lhs, const BasicAddressBook& rhs) { return lhs.differenceWith(rhs); }
+
+
+	/*
+	* @brief Overload the and operator so we can intersect two address books
+	*
+	* @param lhs The address book to keep entries of
+	* @param rhs The address book the kept entries must also be in
+	* @return AddressBook The entries of lhs that are also in rhs, see intersectionWith
+	*/
+	friend BasicAddressBook operator&(const BasicAddressBook& lhs, const BasicAddressBook& rhs) { return lhs.intersectionWith(rhs); }
+
+
+	/*
+	* @brief Return the entries of this address book plus the entries of rhs that aren't in it
+	*
+	* Both address books are split into partitions by entry fingerprint and the partitions are matched in parallel on
+	* pool, then the entries of the result are copied, and its filters and maps built, in parallel too. Only linking the
+	* map nodes built by every partition into the maps runs on one thread (std::map can't be filled from several).
+	* The entries of this address book keep their order and come first, followed by the new entries in rhs order.
+	* The additions are recorded in the change feed of the result.
+	*
+	* @param rhs The address book to add
+	* @param pool The pool to run on (the calling thread helps)
+	* @return AddressBook The union of both address books
+	*/
+	BasicAddressBook unionWith(const BasicAddressBook& rhs, WorkStealingPool& pool = WorkStealingPool::shared()) const;
+
+
+	/*
+	* @brief Return the entries of this address book that aren't in rhs
+	*
+	* Partitioned and run on pool like unionWith. The kept entries keep their order and the removals are recorded in the
+	* change feed of the result.
+	*
+	* @param rhs The address book to subtract
+	* @param pool The pool to run on (the calling thread helps)
+	* @return AddressBook The difference of both address books
+	*/
+	BasicAddressBook differenceWith(const BasicAddressBook& rhs, WorkStealingPool& pool = WorkStealingPool::shared()) const;
+
+
+	/*
+	* @brief Return the entries of this address book that are also in rhs
+	*
+	* Partitioned and run on pool like unionWith. The kept entries keep their order and the entries dropped are recorded
+	* as removals in the change feed of the result.
+	*
+	* @param rhs The address book to intersect with
+	* @param pool The pool to run on (the calling thread helps)
+	* @return AddressBook The intersection of both address books
 	*/
-	AddressBook operator-(const AddressBook& rhs);
-	friend AddressBook operator-(const AddressBook& lhs, const AddressBook& rhs);
+	BasicAddressBook intersectionWith(const BasicAddressBook& rhs, WorkStealingPool& pool = WorkStealingPool::shared()) const;
 
 
 	/*
@@ -113,6 +605,7 @@ public:
 	* @param person The person to add
 	* @throws std::invalid_argument if the entry does not have a first or last name
 	* @throws std::invalid_argument if the entry already exists
+	* @throws std::length_error if a name or the phone number is longer than 65535 bytes
 	* @return void
 	* 
 	* Note: It's probably a good idea to call this method in a try catch block as it throws an exception if the entry
@@ -123,11 +616,24 @@ public:
 	void add(const Entry& person);
 
 
+	/*
+	* @brief Add a person to the address book, reporting failures in the result rather than with an exception
+	*
+	* Same as add, for callers (and bulk paths) where duplicates are routine and throwing for each one would cost more
+	* than the add itself.
+	*
+	* @param person The person to add
+	* @return AddressBook::Status Ok, MissingName, FieldTooLong or AlreadyExists (the address book is unchanged unless Ok)
+	*/
+	[[nodiscard]] Status tryAdd(const Entry& person);
+
+
 	/*
 	* @brief Remove a person from the address book
 	* 
 	* @param person The person to remove
 	* @throws std::invalid_argument if the entry does not exist
+	* @throws std::length_error if a name or the phone number is longer than 65535 bytes
 	* @return void
 	* 
 	* Note: Probably also a good idea to call this method in a try catch block as it throws an exception if the entry 
@@ -138,6 +644,25 @@ public:
 	void remove(const Entry& person);
 
 
+	/*
+	* @brief Remove a person from the address book, reporting failures in the result rather than with an exception
+	*
+	* @param person The person to remove
+	* @return AddressBook::Status Ok, FieldTooLong or NotFound (the address book is unchanged unless Ok)
+	*/
+	[[nodiscard]] Status tryRemove(const Entry& person);
+
+
+	/*
+	* @brief Start a batch of mutations, see Transaction
+	*
+	* Usage: auto transaction = book.begin(); transaction.add(...); transaction.remove(...); transaction.commit();
+	*
+	* @return Transaction An empty transaction on this address book
+	*/
+	Transaction begin() { return Transaction(*this); }
+
+
 	/*
 	* @brief Return all entries sorted by first name
 	* 
@@ -146,8 +671,9 @@ public:
 	* 
 	* @return std::vector<AddressBook::Entry> The entries sorted by first name
 	*
+	* Only available if the policy enables the first name index
 	*/
-	std::vector<Entry> sortedByFirstName();
+	std::vector<Entry> sortedByFirstName() requires Policy::first_name_index;
 
 
 	/*
@@ -157,22 +683,169 @@ public:
 	* already sorted by last name
 	* 
 	* @return std::vector<AddressBook::Entry> The entries sorted by last name
+	*
+	* Only available if the policy enables the last name index
 	*/
-	std::vector<Entry> sortedByLastName();
+	std::vector<Entry> sortedByLastName() requires Policy::last_name_index;
 
 
 	/*
 	* @brief Return all entries that match the prefix (case insensitive)
 	* 
 	* Finds all entries that match the prefix (case insensitive) and returns them in a vector. Uses the first and last
-	* name maps to find entries that match the prefix.
+	* name maps to find entries that match the prefix (only the ones the policy enables).
 	* 
 	* @param prefix The prefix to match
 	* @return std::vector<AddressBook::Entry> The entries that match the prefix
 	* 
 	* Note: Might be a good idea to use a prefix tree for this but potentially will take more memory as the tree will need to 
 	* store the first and last name of each entry. (Future improvement)
+	* If the find cache is enabled (see enableFindCache) repeated prefixes are answered from the cache.
 	*/
 	std::vector<Entry> find(const std::string & name);
 
-};
\ No newline at end of file
+
+	/*
+	* @brief Return all entries whose first or last name is name (case insensitive)
+	*
+	* Uses the name maps the policy enables, like find. Names that aren't in the address book are usually turned away by
+	* a Bloom filter without looking in the maps.
+	*
+	* @param name The name to match
+	* @return std::vector<AddressBook::Entry> The matching entries, first name matches first
+	*/
+	std::vector<Entry> findExact(const std::string& name);
+
+
+	/*
+	* @brief Return all entries that match the prefix (case insensitive), allocating from a request scoped resource
+	*
+	* Same as find but the results, and all the temporary memory used to work them out, come from resource. Handy with
+	* a std::pmr::monotonic_buffer_resource that is released once the request has been answered.
+	*
+	* @param prefix The prefix to match
+	* @param resource The memory resource to allocate the results and scratch memory from
+	* @return std::pmr::vector<AddressBook::Entry> The entries that match the prefix
+	*/
+	std::pmr::vector<Entry> find(const std::string& prefix, std::pmr::memory_resource* resource);
+
+
+	/*
+	* @brief Return all entries whose phone number starts with the given digits
+	*
+	* Anything that isn't a digit is ignored, in the prefix and in the phone numbers, so "+44 7700" matches
+	* "+44 7700 900297". Only available if the policy enables the phone index.
+	*
+	* @param prefix The phone number prefix to match
+	* @return std::vector<AddressBook::Entry> The matching entries, ordered by phone number
+	*/
+	std::vector<Entry> findByPhone(const std::string& prefix) requires Policy::phone_index;
+
+
+	/*
+	* @brief Return all entries with a word in their first or last name that starts with the prefix
+	*
+	* Names are split into words at anything that isn't a letter or a digit, so "ann" matches "Mary Ann" and "jones"
+	* matches "Smith-Jones". Only available if the policy enables the full text index.
+	*
+	* @param prefix The prefix to match
+	* @return std::vector<AddressBook::Entry> The matching entries, ordered by the matching word
+	*/
+	std::vector<Entry> findFullText(const std::string& prefix) requires Policy::full_text_index;
+
+
+	/*
+	* @brief Return the memory resource the address book allocates from
+	*
+	* @return std::pmr::memory_resource* The memory resource
+	*/
+	std::pmr::memory_resource* memoryResource() const { return resource; }
+
+
+	/*
+	* @brief Enable an LRU cache in front of find
+	*
+	* Caches the results of up to capacity distinct (lower cased) prefixes. add and remove only drop the cached prefixes
+	* that could be affected by the names they touch. Useful for autocomplete style traffic where the same short
+	* prefixes are searched for over and over again.
+	* Copies of the address book start with an empty cache of the same capacity.
+	*
+	* @param capacity The maximum number of prefixes to cache (0 disables the cache)
+	* @return void
+	*/
+	void enableFindCache(size_t capacity);
+
+
+	/*
+	* @brief Disable the find cache and drop everything in it
+	*
+	* @return void
+	*/
+	void disableFindCache() { enableFindCache(0); }
+
+
+	/*
+	* @brief Return the hit and miss counters of the find cache
+	*
+	* @return AddressBook::FindCacheStats The cache counters
+	*/
+	FindCacheStats findCacheStats() const;
+
+
+	/*
+	* @brief Return a snapshot of the address book instrumentation
+	*
+	* Per operation call counts and latency histograms are only recorded when the library is built with
+	* ADDRESSBOOK_ENABLE_STATS, otherwise they are left empty. The size gauges (entries, map keys, largest map buckets) are
+	* computed by this call and are always available. Use AddressBookStats::writeText or writeJson to dump them.
+	*
+	* @return AddressBookStats The current stats
+	*/
+	AddressBookStats stats() const;
+
+
+	/*
+	* @brief Forget all recorded call counts and latencies
+	*
+	* @return void
+	*/
+	void resetStats() { operation_recorder.reset(); }
+
+
+	/*
+	* @brief Return the current version of the address book
+	*
+	* The version starts at 0 and is incremented by one for every entry added or removed. Consumers can remember the
+	* version they last synced at and pass it to changesSince to catch up.
+	*
+	* @return uint64_t The current version
+	*/
+	uint64_t version() const { return current_version; }
+
+
+	/*
+	* @brief Return every change made after the given version, oldest first
+	*
+	* Only the most recent changes are kept (see the change_feed_capacity constructor argument). If the consumer has
+	* fallen further behind than that, it has to resync from a snapshot (e.g. sortedByFirstName and version).
+	*
+	* @param version The version the consumer last synced at
+	* @throws std::out_of_range if the changes after version are no longer in the change feed
+	* @throws std::invalid_argument if version is newer than the current version
+	* @return std::vector<AddressBook::Change> The changes with a version greater than the given version
+	*/
+	std::vector<Change> changesSince(uint64_t version) const;
+
+};
+
+#include "address_book_impl.h"
+
+// The policies in address_book_policies.h are instantiated once in address_book.cpp
+extern template class BasicAddressBook<DefaultIndexPolicy>;
+extern template class BasicAddressBook<LastNameIndexPolicy>;
+extern template class BasicAddressBook<FullIndexPolicy>;
+extern template class BasicAddressBook<CaseSensitiveIndexPolicy>;
+extern template class BasicAddressBook<AccentInsensitiveIndexPolicy>;
+
+// The address book with the default set of indexes (first and last name, case insensitive)
+using AddressBook = BasicAddressBook<DefaultIndexPolicy>;
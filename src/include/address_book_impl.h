@@ -0,0 +1,1373 @@
+#pragma once
+
+// Definitions of the BasicAddressBook members, included at the end of address_book.h so an address book can be used
+// with any index policy. Don't include this file directly.
+
+#include <stdexcept>
+#include <algorithm>
+#include <iterator>
+#include <unordered_set>
+#include <array>
+#include <cctype>
+#include <cstddef>
+#include <tuple>
+
+
+namespace detail
+{
+	// Keep only the digits of a phone number so differently formatted numbers share keys
+	inline std::pmr::string phoneDigits(std::string_view phone_number, std::pmr::memory_resource* resource)
+	{
+		std::pmr::string digits(resource);
+		for (char c : phone_number) {
+			if (::isdigit(static_cast<unsigned char>(c))) {
+				digits.push_back(c);
+			}
+		}
+		return digits;
+	}
+
+
+	// Split an already folded name into its words (runs of letters and digits) and add them to words
+	inline void splitWords(std::string_view name, std::pmr::vector<std::pmr::string>& words)
+	{
+		auto is_word_char = [](char c) { return ::isalnum(static_cast<unsigned char>(c)) != 0; };
+
+		auto it = name.begin();
+		while (it != name.end()) {
+			auto word_begin = std::find_if(it, name.end(), is_word_char);
+			auto word_end = std::find_if_not(word_begin, name.end(), is_word_char);
+			if (word_begin != word_end) {
+				words.emplace_back(word_begin, word_end);
+			}
+			it = word_end;
+		}
+	}
+}
+
+
+template <typename Policy>
+BasicAddressBook<Policy>& BasicAddressBook<Policy>::operator=(const BasicAddressBook& ab)
+{
+	// Build the copy of the entries with this book's resource, copy assigning them would spill to the default resource
+	entries = std::pmr::vector<CompactEntry>(ab.entries, resource);
+	fingerprints = ab.fingerprints;
+	entry_filter = ab.entry_filter;
+	name_filter = ab.name_filter;
+	first_name_map = ab.first_name_map;
+	last_name_map = ab.last_name_map;
+	phone_map = ab.phone_map;
+	full_text_map = ab.full_text_map;
+	index_generation++;
+	current_version = ab.current_version;
+	change_feed = ab.change_feed;
+	change_feed_head = ab.change_feed_head;
+	change_feed_capacity = ab.change_feed_capacity;
+	operation_recorder = ab.operation_recorder;
+
+	// Cached results are not copied, start with an empty cache of the same size
+	find_cache_lru.clear();
+	find_cache_index.clear();
+	find_cache_capacity = ab.find_cache_capacity;
+	return *this;
+}
+
+
+// Move assignment operator
+template <typename Policy>
+BasicAddressBook<Policy>& BasicAddressBook<Policy>::operator=(BasicAddressBook&& ab) noexcept
+{
+	// Takes the entries over when both books use the same resource, otherwise copies their spilled bytes to this one
+	entries = std::pmr::vector<CompactEntry>(std::move(ab.entries), resource);
+	fingerprints = std::move(ab.fingerprints);
+	entry_filter = std::move(ab.entry_filter);
+	name_filter = std::move(ab.name_filter);
+	first_name_map = std::move(ab.first_name_map);
+	last_name_map = std::move(ab.last_name_map);
+	phone_map = std::move(ab.phone_map);
+	full_text_map = std::move(ab.full_text_map);
+	index_generation++;
+	ab.index_generation++;
+	current_version = ab.current_version;
+	change_feed = std::move(ab.change_feed);
+	change_feed_head = ab.change_feed_head;
+	change_feed_capacity = ab.change_feed_capacity;
+	// Moving a list keeps its iterators valid so the cache index can be moved along with it, but only if both address
+	// books use the same memory resource (otherwise the nodes are copied one by one)
+	if (*resource == *ab.resource) {
+		find_cache_lru = std::move(ab.find_cache_lru);
+		find_cache_index = std::move(ab.find_cache_index);
+	}
+	else {
+		find_cache_lru.clear();
+		find_cache_index.clear();
+	}
+	find_cache_capacity = ab.find_cache_capacity;
+	find_cache_hits = ab.find_cache_hits;
+	find_cache_misses = ab.find_cache_misses;
+	operation_recorder = ab.operation_recorder;
+	return *this;
+}
+
+
+template <typename Policy>
+BasicAddressBook<Policy> BasicAddressBook<Policy>::operator-(const BasicAddressBook& rhs)
+{
+	[[maybe_unused]] auto timer = operation_recorder.time(AddressBookOperation::Difference);
+
+	// Remove all entries that are in rhs from this
+	WorkStealingPool& pool = WorkStealingPool::shared();
+	std::vector<char> in_rhs = matchEntries(rhs, pool);
+	gatherEntries({ { this, &in_rhs, false, false } }, pool);
+	return *this;
+}
+
+
+template <typename Policy>
+BasicAddressBook<Policy> BasicAddressBook<Policy>::unionWith(const BasicAddressBook& rhs, WorkStealingPool& pool) const
+{
+	BasicAddressBook result = copyWithoutEntries();
+	[[maybe_unused]] auto timer = result.operation_recorder.time(AddressBookOperation::Union);
+
+	// Keep all of our entries and append the rhs entries we don't have, in rhs order
+	std::vector<char> in_lhs = rhs.matchEntries(*this, pool);
+	result.gatherEntries({ { this, nullptr, true, false }, { &rhs, &in_lhs, false, true } }, pool);
+	return result;
+}
+
+
+template <typename Policy>
+BasicAddressBook<Policy> BasicAddressBook<Policy>::differenceWith(const BasicAddressBook& rhs, WorkStealingPool& pool) const
+{
+	BasicAddressBook result = copyWithoutEntries();
+	[[maybe_unused]] auto timer = result.operation_recorder.time(AddressBookOperation::Difference);
+
+	std::vector<char> in_rhs = matchEntries(rhs, pool);
+	result.gatherEntries({ { this, &in_rhs, false, false } }, pool);
+	return result;
+}
+
+
+template <typename Policy>
+BasicAddressBook<Policy> BasicAddressBook<Policy>::intersectionWith(const BasicAddressBook& rhs, WorkStealingPool& pool) const
+{
+	BasicAddressBook result = copyWithoutEntries();
+	[[maybe_unused]] auto timer = result.operation_recorder.time(AddressBookOperation::Intersection);
+
+	std::vector<char> in_rhs = matchEntries(rhs, pool);
+	result.gatherEntries({ { this, &in_rhs, true, false } }, pool);
+	return result;
+}
+
+
+template <typename Policy>
+BasicAddressBook<Policy> BasicAddressBook<Policy>::copyWithoutEntries() const
+{
+	BasicAddressBook copy(ChangeFeedCapacity{ change_feed_capacity });
+	copy.current_version = current_version;
+	copy.change_feed = change_feed;
+	copy.change_feed_head = change_feed_head;
+	copy.find_cache_capacity = find_cache_capacity;
+	copy.operation_recorder = operation_recorder;
+	return copy;
+}
+
+
+template <typename Policy>
+size_t BasicAddressBook<Policy>::partitionCount(size_t entry_count, const WorkStealingPool& pool)
+{
+	if (entry_count < parallel_threshold || pool.threadCount() == 0) {
+		return 1;
+	}
+	return (pool.threadCount() + 1) * partitions_per_thread;
+}
+
+
+template <typename Policy>
+std::vector<char> BasicAddressBook<Policy>::matchEntries(const BasicAddressBook& other, WorkStealingPool& pool) const
+{
+	size_t partition_count = partitionCount(entries.size() + other.entries.size(), pool);
+
+	// Split the entries of a book into the partitions, as many chunks of the book in parallel as there are partitions
+	// Returns the indices of the entries of every chunk and partition, chunk major
+	auto scatter = [partition_count, &pool](const BasicAddressBook& book) {
+		std::vector<std::vector<size_t>> buckets(partition_count * partition_count);
+		pool.parallelFor(partition_count, [&](size_t chunk) {
+			size_t begin = book.entries.size() * chunk / partition_count;
+			size_t end = book.entries.size() * (chunk + 1) / partition_count;
+			for (size_t i = begin; i < end; i++) {
+				buckets.at(chunk * partition_count + book.fingerprints.at(i) % partition_count).push_back(i);
+			}
+		});
+		return buckets;
+	};
+	std::vector<std::vector<size_t>> our_buckets = scatter(*this);
+	std::vector<std::vector<size_t>> other_buckets = scatter(other);
+
+	// Every partition only writes the flags of its own entries
+	// Note: The scratch memory comes from the global heap rather than resource, which may not be thread safe
+	std::vector<char> matched(entries.size(), 0);
+	pool.parallelFor(partition_count, [&](size_t partition) {
+		size_t other_count = 0;
+		for (size_t chunk = 0; chunk < partition_count; chunk++) {
+			other_count += other_buckets.at(chunk * partition_count + partition).size();
+		}
+
+		// Index the other book's entries of the partition by fingerprint so each of our entries only has to be compared
+		// with the entries that have the same fingerprint (almost always none or the one equal entry)
+		std::unordered_multimap<uint64_t, size_t> other_indices;
+		other_indices.reserve(other_count);
+		for (size_t chunk = 0; chunk < partition_count; chunk++) {
+			for (size_t i : other_buckets.at(chunk * partition_count + partition)) {
+				other_indices.emplace(other.fingerprints.at(i), i);
+			}
+		}
+
+		for (size_t chunk = 0; chunk < partition_count; chunk++) {
+			for (size_t i : our_buckets.at(chunk * partition_count + partition)) {
+				auto [begin, end] = other_indices.equal_range(fingerprints.at(i));
+				for (auto it = begin; it != end; it++) {
+					if (other.entries.at(it->second) == entries.at(i)) {
+						matched.at(i) = 1;
+						break;
+					}
+				}
+			}
+
+			// Free the buckets here rather than all of them on the calling thread
+			our_buckets.at(chunk * partition_count + partition) = {};
+			other_buckets.at(chunk * partition_count + partition) = {};
+		}
+	});
+
+	return matched;
+}
+
+
+template <typename Policy>
+void BasicAddressBook<Policy>::gatherEntries(std::initializer_list<EntrySource> sources, WorkStealingPool& pool)
+{
+	// A run of consecutive entries of a source, where its kept entries go and how many changes it records
+	struct Chunk
+	{
+		const EntrySource* source;
+		size_t begin;
+		size_t end;
+		size_t offset = 0;
+		size_t kept = 0;
+		size_t recorded = 0;
+	};
+
+	auto isKept = [](const EntrySource& source, size_t i) {
+		return source.matched == nullptr || (source.matched->at(i) != 0) == source.keep_matched;
+	};
+
+	std::vector<Chunk> chunks;
+	for (const EntrySource& source : sources) {
+		size_t size = source.book->entries.size();
+		size_t chunk_count = partitionCount(size, pool);
+		for (size_t chunk = 0; chunk < chunk_count; chunk++) {
+			chunks.push_back({ &source, size * chunk / chunk_count, size * (chunk + 1) / chunk_count });
+		}
+	}
+
+	// Count the entries every chunk keeps, then give every chunk its place in the new entries (a prefix sum)
+	pool.parallelFor(chunks.size(), [&](size_t index) {
+		Chunk& chunk = chunks.at(index);
+		for (size_t i = chunk.begin; i < chunk.end; i++) {
+			chunk.kept += isKept(*chunk.source, i);
+		}
+		chunk.recorded = chunk.source->record_kept ? chunk.kept : chunk.end - chunk.begin - chunk.kept;
+	});
+	size_t total = 0;
+	size_t recorded = 0;
+	for (Chunk& chunk : chunks) {
+		chunk.offset = total;
+		total += chunk.kept;
+		recorded += chunk.recorded;
+	}
+
+	// Every chunk copies its kept entries into its own slice
+	std::pmr::vector<CompactEntry> gathered(total, resource);
+	std::pmr::vector<uint64_t> gathered_fingerprints(total, resource);
+	auto copyChunk = [&](size_t index) {
+		const Chunk& chunk = chunks.at(index);
+		const BasicAddressBook& book = *chunk.source->book;
+		size_t out = chunk.offset;
+		for (size_t i = chunk.begin; i < chunk.end; i++) {
+			if (isKept(*chunk.source, i)) {
+				gathered.at(out) = CompactEntry(book.entries.at(i), resource);
+				gathered_fingerprints.at(out) = book.fingerprints.at(i);
+				out++;
+			}
+		}
+	};
+	if (resourceIsThreadSafe()) {
+		pool.parallelFor(chunks.size(), copyChunk);
+	}
+	else {
+		for (size_t index = 0; index < chunks.size(); index++) {
+			copyChunk(index);
+		}
+	}
+
+	// Record the changes while the sources are still there (one may be this address book)
+	// Only the newest change_feed_capacity changes are kept, skip the chunks that only hold older ones
+	size_t unrecorded = recorded > change_feed_capacity ? recorded - change_feed_capacity : 0;
+	current_version += unrecorded;
+	for (const Chunk& chunk : chunks) {
+		if (unrecorded >= chunk.recorded) {
+			unrecorded -= chunk.recorded;
+			continue;
+		}
+
+		const EntrySource& source = *chunk.source;
+		for (size_t i = chunk.begin; i < chunk.end; i++) {
+			if (isKept(source, i) != source.record_kept) {
+				continue;
+			}
+			if (unrecorded > 0) {
+				unrecorded--;
+				continue;
+			}
+			recordChange(source.record_kept ? ChangeType::Added : ChangeType::Removed, source.book->entries.at(i).toEntry());
+		}
+	}
+
+	entries = std::move(gathered);
+	fingerprints = std::move(gathered_fingerprints);
+
+	// Many entries may have moved so drop the whole cache rather than working out which prefixes are affected
+	find_cache_lru.clear();
+	find_cache_index.clear();
+
+	refilterParallel(pool);
+	rebuildMapsParallel(pool);
+}
+
+
+template <typename Policy>
+void BasicAddressBook<Policy>::refilterParallel(WorkStealingPool& pool)
+{
+	size_t capacity = std::max({ entries.size(), entry_filter.capacity(), min_filter_capacity });
+	entry_filter = CountingBloomFilter(capacity, resource);
+	name_filter = CountingBloomFilter(capacity * names_per_entry, resource);
+
+	size_t chunk_count = partitionCount(entries.size(), pool);
+	if (chunk_count == 1) {
+		for (size_t i = 0; i < entries.size(); i++) {
+			filterEntry(i);
+		}
+		return;
+	}
+
+	// The hashes of every chunk of entries, by the slice of the filters they land in (chunk major)
+	struct SliceHashes
+	{
+		std::vector<uint64_t> entry_hashes;
+		std::vector<uint64_t> name_hashes;
+	};
+	std::vector<SliceHashes> buckets(chunk_count * chunk_count);
+	pool.parallelFor(chunk_count, [&](size_t chunk) {
+		auto addName = [&](std::string_view name_lower) {
+			uint64_t hash = nameHash(name_lower);
+			buckets.at(chunk * chunk_count + name_filter.sliceOf(hash, chunk_count)).name_hashes.push_back(hash);
+		};
+
+		size_t begin = entries.size() * chunk / chunk_count;
+		size_t end = entries.size() * (chunk + 1) / chunk_count;
+		for (size_t i = begin; i < end; i++) {
+			uint64_t fingerprint = fingerprints.at(i);
+			buckets.at(chunk * chunk_count + entry_filter.sliceOf(fingerprint, chunk_count)).entry_hashes.push_back(fingerprint);
+			if constexpr (Policy::first_name_index) {
+				addName(entries.at(i).firstNameFolded());
+			}
+			if constexpr (Policy::last_name_index) {
+				addName(entries.at(i).lastNameFolded());
+			}
+		}
+	});
+
+	// Slices are disjoint runs of counters so they are filled at the same time
+	pool.parallelFor(chunk_count, [&](size_t slice) {
+		for (size_t chunk = 0; chunk < chunk_count; chunk++) {
+			SliceHashes& hashes = buckets.at(chunk * chunk_count + slice);
+			for (uint64_t hash : hashes.entry_hashes) {
+				entry_filter.insert(hash);
+			}
+			for (uint64_t hash : hashes.name_hashes) {
+				name_filter.insert(hash);
+			}
+			hashes = {};
+		}
+	});
+}
+
+
+template <typename Policy>
+void BasicAddressBook<Policy>::rebuildMapsParallel(WorkStealingPool& pool)
+{
+	// Nothing to split up, inserting the keys straight into the maps is quicker than collecting and sorting them first
+	size_t chunk_count = partitionCount(entries.size(), pool);
+	if (chunk_count == 1) {
+		rebuildMaps();
+		return;
+	}
+
+	[[maybe_unused]] auto timer = operation_recorder.time(AddressBookOperation::RebuildMaps);
+
+	first_name_map.clear();
+	last_name_map.clear();
+	phone_map.clear();
+	full_text_map.clear();
+	index_generation++;
+
+	// Collect the keys of every chunk of entries
+	// The keys are allocated from the (thread safe) global heap, they are copied into resource when the maps are filled
+	std::vector<std::vector<IndexKey>> chunks(chunk_count);
+	pool.parallelFor(chunk_count, [&](size_t chunk) {
+		size_t begin = entries.size() * chunk / chunk_count;
+		size_t end = entries.size() * (chunk + 1) / chunk_count;
+		std::vector<IndexKey>& keys = chunks.at(chunk);
+		for (size_t i = begin; i < end; i++) {
+			visitIndexKeys(i, std::pmr::new_delete_resource(), [&keys, i](NameMap& map, std::pmr::string key) {
+				keys.push_back({ &map, std::move(key), i });
+			});
+		}
+	});
+
+	// Pick splitters that cut the keys into chunk_count ranges of about the same size from a sorted sample of every
+	// chunk. Ranges are split by map and key only, so all the entries of a key land in the same range.
+	auto keyLess = [](const IndexKey& lhs, const IndexKey& rhs) {
+		return std::tie(lhs.map, lhs.key) < std::tie(rhs.map, rhs.key);
+	};
+	constexpr size_t samples_per_chunk = 16;
+	std::vector<IndexKey> samples;
+	for (const std::vector<IndexKey>& keys : chunks) {
+		for (size_t sample = 0; sample < samples_per_chunk && !keys.empty(); sample++) {
+			samples.push_back(keys.at(keys.size() * sample / samples_per_chunk));
+		}
+	}
+	std::sort(samples.begin(), samples.end());
+	std::vector<IndexKey> splitters;
+	for (size_t range = 1; range < chunk_count && !samples.empty(); range++) {
+		splitters.push_back(std::move(samples.at(samples.size() * range / chunk_count)));
+	}
+
+	// Scatter the keys of every chunk into the ranges (chunk major)
+	std::vector<std::vector<IndexKey>> buckets(chunk_count * chunk_count);
+	pool.parallelFor(chunk_count, [&](size_t chunk) {
+		for (IndexKey& key : chunks.at(chunk)) {
+			size_t range = std::upper_bound(splitters.begin(), splitters.end(), key, keyLess) - splitters.begin();
+			buckets.at(chunk * chunk_count + range).push_back(std::move(key));
+		}
+		chunks.at(chunk) = {};
+	});
+
+	// Sort every range and, if resource allows it, build its part of every map it has keys of as a map of its own
+	bool build_in_parallel = resourceIsThreadSafe();
+	std::vector<std::vector<IndexKey>> ranges(chunk_count);
+	std::vector<std::vector<std::pair<NameMap*, NameMap>>> range_maps(chunk_count);
+	pool.parallelFor(chunk_count, [&](size_t range) {
+		std::vector<IndexKey>& keys = ranges.at(range);
+		for (size_t chunk = 0; chunk < chunk_count; chunk++) {
+			std::vector<IndexKey>& bucket = buckets.at(chunk * chunk_count + range);
+			keys.insert(keys.end(), std::make_move_iterator(bucket.begin()), std::make_move_iterator(bucket.end()));
+			bucket = {};
+		}
+		std::sort(keys.begin(), keys.end());
+		if (!build_in_parallel) {
+			return;
+		}
+
+		// The keys of every map are next to each other, point them at the range's own map instead
+		std::vector<std::pair<NameMap*, NameMap>>& maps = range_maps.at(range);
+		for (size_t i = 0; i < keys.size(); i++) {
+			if (i == 0 || keys.at(i).map != keys.at(i - 1).map) {
+				maps.emplace_back(keys.at(i).map, NameMap(resource));
+			}
+		}
+		size_t map = 0;
+		for (IndexKey& key : keys) {
+			if (key.map != maps.at(map).first) {
+				map++;
+			}
+			key.map = &maps.at(map).second;
+		}
+		mergeIndexKeys(keys);
+		keys = {};
+	});
+
+	// Ranges are in key order, so every node or key goes at the end of its map
+	for (size_t range = 0; range < chunk_count; range++) {
+		if (!build_in_parallel) {
+			mergeIndexKeys(ranges.at(range));
+			continue;
+		}
+		for (auto& [map, range_map] : range_maps.at(range)) {
+			while (!range_map.empty()) {
+				map->insert(map->end(), range_map.extract(range_map.begin()));
+			}
+		}
+	}
+}
+
+
+template <typename Policy>
+void BasicAddressBook<Policy>::throwIfFailed(Status status)
+{
+	switch (status) {
+	case Status::Ok: return;
+	case Status::MissingName: throw std::invalid_argument("Entry does not have a first and last name");
+	case Status::AlreadyExists: throw std::invalid_argument("Entry already exists");
+	case Status::NotFound: throw std::invalid_argument("Entry does not exist");
+	case Status::FieldTooLong: throw std::length_error("Entry field is too long");
+	}
+}
+
+
+template <typename Policy>
+void BasicAddressBook<Policy>::add(const Entry& person)
+{
+	throwIfFailed(tryAdd(person));
+}
+
+
+template <typename Policy>
+typename BasicAddressBook<Policy>::Status BasicAddressBook<Policy>::tryAdd(const Entry& person)
+{
+	[[maybe_unused]] auto timer = operation_recorder.time(AddressBookOperation::Add);
+
+	// Check if the entry has a first name and/or a last name
+	if (person.first_name.empty() && person.last_name.empty()) {
+		return Status::MissingName;
+	}
+
+	// Entries with fields too long to pack can't be added, turn them away before doing any work
+	if (!CompactEntry::fits({ person.first_name, person.last_name, person.phone_number })) {
+		return Status::FieldTooLong;
+	}
+
+	// Most new entries aren't in the entry filter and skip the duplicate check altogether
+	uint64_t fingerprint = CompactEntry::fingerprint(person);
+	bool may_exist = entry_filter.mayContain(fingerprint);
+
+	// Lower case (case fold) the first and last names for the maps (We store the folded versions of the names)
+	// They are only needed until the entry is packed, so they live on the stack unless the names are very long
+	std::array<std::byte, 512> scratch_buffer;
+	std::pmr::monotonic_buffer_resource scratch(scratch_buffer.data(), scratch_buffer.size(), resource);
+
+	std::pmr::string first_name_lower(person.first_name, &scratch);
+	Policy::case_folding::fold(first_name_lower);
+
+	std::pmr::string last_name_lower(person.last_name, &scratch);
+	Policy::case_folding::fold(last_name_lower);
+
+	// A user defined case folding could make a name longer
+	if (!CompactEntry::fits({ first_name_lower, last_name_lower })) {
+		return Status::FieldTooLong;
+	}
+
+	// Pack the entry with its folded names, this is also what we compare against the existing entries
+	// The names are only ever folded here, everything else uses the folded names stored in the entry
+	// A long entry spills to the scratch memory for now and is only copied to resource once it is known to be new
+	CompactEntry compact(person, first_name_lower, last_name_lower, &scratch);
+
+	// Time the duplicate checks on their own as they can dominate add for common names
+	if (may_exist) {
+		[[maybe_unused]] auto duplicate_check_timer = operation_recorder.time(AddressBookOperation::AddDuplicateCheck);
+
+		if (locate(compact, fingerprint) != no_entry) {
+			return Status::AlreadyExists;
+		}
+	}
+
+	// If we get here, the entry does not exist in the address book
+	// Add the entry to the entries vector, which copies spilled bytes to resource
+	reserveFilters(entries.size() + 1);
+	entries.push_back(std::move(compact));
+	fingerprints.push_back(fingerprint);
+
+	// Add the entry to the filters and the maps
+	filterEntry(entries.size() - 1);
+	indexEntry(entries.size() - 1);
+
+	// Drop cached results that should now include the new entry
+	invalidateFindCache(first_name_lower);
+	invalidateFindCache(last_name_lower);
+
+	recordChange(ChangeType::Added, person);
+	return Status::Ok;
+}
+
+
+template <typename Policy>
+void BasicAddressBook<Policy>::remove(const Entry& person)
+{
+	throwIfFailed(tryRemove(person));
+}
+
+
+template <typename Policy>
+typename BasicAddressBook<Policy>::Status BasicAddressBook<Policy>::tryRemove(const Entry& person)
+{
+	[[maybe_unused]] auto timer = operation_recorder.time(AddressBookOperation::Remove);
+
+	// Entries with fields too long to pack can't be in the address book
+	if (!CompactEntry::fits({ person.first_name, person.last_name, person.phone_number })) {
+		return Status::FieldTooLong;
+	}
+
+	// Entries that aren't in the entry filter definitely don't exist, turn them away before folding or packing anything
+	uint64_t fingerprint = CompactEntry::fingerprint(person);
+	if (!entry_filter.mayContain(fingerprint)) {
+		return Status::NotFound;
+	}
+
+	// Lower case the first and last names for the maps, on the stack unless the names are very long
+	std::array<std::byte, 512> scratch_buffer;
+	std::pmr::monotonic_buffer_resource scratch(scratch_buffer.data(), scratch_buffer.size(), resource);
+
+	std::pmr::string first_name_lower(person.first_name, &scratch);
+	Policy::case_folding::fold(first_name_lower);
+
+	std::pmr::string last_name_lower(person.last_name, &scratch);
+	Policy::case_folding::fold(last_name_lower);
+
+	if (!CompactEntry::fits({ first_name_lower, last_name_lower })) {
+		return Status::FieldTooLong;
+	}
+
+	// Pack the entry so it can be compared with the existing entries, it is only needed for this call
+	CompactEntry compact(person, first_name_lower, last_name_lower, &scratch);
+	size_t match_index = locate(compact, fingerprint);
+	if (match_index == no_entry) {
+		return Status::NotFound;
+	}
+
+	recordChange(ChangeType::Removed, person);
+
+	// Drop cached results that include the removed entry
+	invalidateFindCache(first_name_lower);
+	invalidateFindCache(last_name_lower);
+
+	unfilterEntry(match_index);
+
+	// Fast remove the entry from the first name map, we can do this because we don't care about the order of the indices
+	if (match_index != entries.size() - 1) {
+		// The last entry is about to move to a new index which can change its position in cached results
+		// The entry keeps its folded names so they don't need working out again
+		invalidateFindCache(entries.back().firstNameFolded());
+		invalidateFindCache(entries.back().lastNameFolded());
+
+		// Swap the entry we want to remove with the last entry in the entries vector
+		std::swap(entries.at(match_index), entries.at(entries.size() - 1));
+		std::swap(fingerprints.at(match_index), fingerprints.at(fingerprints.size() - 1));
+	}
+	// Remove the last entry in the entries vector
+	entries.pop_back();
+	fingerprints.pop_back();
+
+	// Rebuild the maps
+	rebuildMaps();
+	return Status::Ok;
+}
+
+
+template <typename Policy>
+void BasicAddressBook<Policy>::recordChange(ChangeType type, const Entry& person)
+{
+	current_version++;
+
+	// Change feed is disabled
+	if (change_feed_capacity == 0) {
+		return;
+	}
+
+	// Fill the buffer up first, after that overwrite the oldest change
+	if (change_feed.size() < change_feed_capacity) {
+		change_feed.push_back({ current_version, type, person });
+	}
+	else {
+		change_feed.at(change_feed_head) = { current_version, type, person };
+		change_feed_head = (change_feed_head + 1) % change_feed_capacity;
+	}
+}
+
+
+template <typename Policy>
+void BasicAddressBook<Policy>::rebuildMaps() {
+	[[maybe_unused]] auto timer = operation_recorder.time(AddressBookOperation::RebuildMaps);
+
+	// Clear the maps
+	first_name_map.clear();
+	last_name_map.clear();
+	phone_map.clear();
+	full_text_map.clear();
+	index_generation++;
+
+	// Rebuild the maps
+	// The entries keep their folded names so rebuilding doesn't have to fold them again
+	for (size_t i = 0; i < entries.size(); i++) {
+		indexEntry(i);
+	}
+}
+
+
+template <typename Policy>
+template <typename Visit>
+void BasicAddressBook<Policy>::visitIndexKeys(size_t index, std::pmr::memory_resource* key_resource, Visit visit)
+{
+	const CompactEntry& entry = entries.at(index);
+
+	if constexpr (Policy::first_name_index) {
+		visit(first_name_map, std::pmr::string(entry.firstNameFolded(), key_resource));
+	}
+	if constexpr (Policy::last_name_index) {
+		visit(last_name_map, std::pmr::string(entry.lastNameFolded(), key_resource));
+	}
+	if constexpr (Policy::phone_index) {
+		visit(phone_map, detail::phoneDigits(entry.phoneNumber(), key_resource));
+	}
+	if constexpr (Policy::full_text_index) {
+		// Index every distinct word of both names once
+		std::pmr::vector<std::pmr::string> words(key_resource);
+		detail::splitWords(entry.firstNameFolded(), words);
+		detail::splitWords(entry.lastNameFolded(), words);
+		std::sort(words.begin(), words.end());
+		words.erase(std::unique(words.begin(), words.end()), words.end());
+
+		for (std::pmr::string& word : words) {
+			visit(full_text_map, std::move(word));
+		}
+	}
+}
+
+
+template <typename Policy>
+void BasicAddressBook<Policy>::indexEntry(size_t index)
+{
+	visitIndexKeys(index, resource, [index](NameMap& map, std::pmr::string key) {
+		map[std::move(key)].push_back(index);
+	});
+}
+
+
+template <typename Policy>
+size_t BasicAddressBook<Policy>::locate(const CompactEntry& compact, uint64_t fingerprint)
+{
+	// The map wants its own key type to look up, build the key on the stack unless the name is very long
+	std::array<std::byte, 256> key_buffer;
+	std::pmr::monotonic_buffer_resource key_scratch(key_buffer.data(), key_buffer.size(), resource);
+
+	NameMap& names = primaryNameMap();
+	auto bucket = names.find(std::pmr::string(
+		Policy::first_name_index ? compact.firstNameFolded() : compact.lastNameFolded(), &key_scratch));
+	if (bucket == names.end()) {
+		return no_entry;
+	}
+
+	for (size_t index : bucket->second) {
+		if (fingerprints.at(index) == fingerprint && entries.at(index) == compact) {
+			return index;
+		}
+	}
+	return no_entry;
+}
+
+
+template <typename Policy>
+void BasicAddressBook<Policy>::reserveFilters(size_t entry_count)
+{
+	if (entry_count <= entry_filter.capacity()) {
+		return;
+	}
+
+	// Counting Bloom filters can't be resized so build new ones from the entries, doubling the capacity each time so
+	// the rebuilds cost O(1) per entry added
+	size_t capacity = std::max({ entry_count, entry_filter.capacity() * 2, min_filter_capacity });
+	entry_filter = CountingBloomFilter(capacity, resource);
+
+	name_filter = CountingBloomFilter(capacity * names_per_entry, resource);
+	for (size_t i = 0; i < entries.size(); i++) {
+		filterEntry(i);
+	}
+}
+
+
+template <typename Policy>
+void BasicAddressBook<Policy>::filterEntry(size_t index)
+{
+	entry_filter.insert(fingerprints.at(index));
+	if constexpr (Policy::first_name_index) {
+		name_filter.insert(nameHash(entries.at(index).firstNameFolded()));
+	}
+	if constexpr (Policy::last_name_index) {
+		name_filter.insert(nameHash(entries.at(index).lastNameFolded()));
+	}
+}
+
+
+template <typename Policy>
+void BasicAddressBook<Policy>::unfilterEntry(size_t index)
+{
+	entry_filter.erase(fingerprints.at(index));
+	if constexpr (Policy::first_name_index) {
+		name_filter.erase(nameHash(entries.at(index).firstNameFolded()));
+	}
+	if constexpr (Policy::last_name_index) {
+		name_filter.erase(nameHash(entries.at(index).lastNameFolded()));
+	}
+}
+
+
+template <typename Policy>
+typename BasicAddressBook<Policy>::Status BasicAddressBook<Policy>::applyBatch(const std::vector<std::pair<ChangeType, Entry>>& mutations)
+{
+	[[maybe_unused]] auto timer = operation_recorder.time(AddressBookOperation::Commit);
+
+	// Every distinct entry the batch touches, where it is in the address book (if it is) and whether it is there once
+	// the mutations so far have been applied
+	struct Touched
+	{
+		CompactEntry entry;
+		uint64_t fingerprint;
+		size_t book_index;
+		bool present;
+	};
+	std::pmr::vector<Touched> touched(resource);
+	std::pmr::unordered_multimap<uint64_t, size_t> touched_by_fingerprint(resource);
+
+	// Check the mutations in order without changing anything, so a failure leaves the address book as it was
+	for (const auto& [type, person] : mutations) {
+		if (type == ChangeType::Added && person.first_name.empty() && person.last_name.empty()) {
+			return Status::MissingName;
+		}
+		if (!CompactEntry::fits({ person.first_name, person.last_name, person.phone_number })) {
+			return Status::FieldTooLong;
+		}
+
+		std::pmr::string first_name_lower(person.first_name, resource);
+		Policy::case_folding::fold(first_name_lower);
+
+		std::pmr::string last_name_lower(person.last_name, resource);
+		Policy::case_folding::fold(last_name_lower);
+
+		if (!CompactEntry::fits({ first_name_lower, last_name_lower })) {
+			return Status::FieldTooLong;
+		}
+
+		CompactEntry compact(person, first_name_lower, last_name_lower, resource);
+		uint64_t fingerprint = compact.fingerprint();
+
+		// Look for the entry among the ones already touched by the batch, then in the address book
+		size_t slot = touched.size();
+		auto [begin, end] = touched_by_fingerprint.equal_range(fingerprint);
+		for (auto it = begin; it != end; it++) {
+			if (touched.at(it->second).entry == compact) {
+				slot = it->second;
+				break;
+			}
+		}
+		if (slot == touched.size()) {
+			size_t book_index = entry_filter.mayContain(fingerprint) ? locate(compact, fingerprint) : no_entry;
+			touched.push_back({ std::move(compact), fingerprint, book_index, book_index != no_entry });
+			touched_by_fingerprint.emplace(fingerprint, slot);
+		}
+
+		Touched& entry = touched.at(slot);
+		if (type == ChangeType::Added) {
+			if (entry.present) {
+				return Status::AlreadyExists;
+			}
+			entry.present = true;
+		}
+		else {
+			if (!entry.present) {
+				return Status::NotFound;
+			}
+			entry.present = false;
+		}
+	}
+
+	// Apply the net effect on every touched entry, removals first
+	std::pmr::vector<bool> removed(entries.size(), false, resource);
+	size_t removed_count = 0;
+	size_t added_count = 0;
+	for (const Touched& entry : touched) {
+		if (entry.book_index != no_entry && !entry.present) {
+			removed.at(entry.book_index) = true;
+			removed_count++;
+		}
+		else if (entry.book_index == no_entry && entry.present) {
+			added_count++;
+		}
+	}
+
+	if (removed_count > 0) {
+		// Compact the entries (keeping their order) and work out where every kept entry ends up
+		std::pmr::vector<size_t> new_index(entries.size(), no_entry, resource);
+		size_t kept = 0;
+		for (size_t i = 0; i < entries.size(); i++) {
+			if (removed.at(i)) {
+				unfilterEntry(i);
+				recordChange(ChangeType::Removed, entries.at(i).toEntry());
+				invalidateFindCache(entries.at(i).firstNameFolded());
+				invalidateFindCache(entries.at(i).lastNameFolded());
+				continue;
+			}
+			if (kept != i) {
+				entries.at(kept) = std::move(entries.at(i));
+				fingerprints.at(kept) = fingerprints.at(i);
+			}
+			new_index.at(i) = kept;
+			kept++;
+		}
+		entries.erase(entries.begin() + kept, entries.end());
+		fingerprints.erase(fingerprints.begin() + kept, fingerprints.end());
+
+		// Renumber the indices in the maps in place, dropping the removed entries (and keys left without entries)
+		// Relative order is kept so the index vectors stay sorted
+		auto renumber = [&new_index](NameMap& map) {
+			for (auto it = map.begin(); it != map.end();) {
+				std::pmr::vector<size_t>& indices = it->second;
+				size_t kept_indices = 0;
+				for (size_t index : indices) {
+					if (new_index.at(index) != no_entry) {
+						indices.at(kept_indices++) = new_index.at(index);
+					}
+				}
+				indices.resize(kept_indices);
+				it = indices.empty() ? map.erase(it) : std::next(it);
+			}
+		};
+		if constexpr (Policy::first_name_index) {
+			renumber(first_name_map);
+		}
+		if constexpr (Policy::last_name_index) {
+			renumber(last_name_map);
+		}
+		if constexpr (Policy::phone_index) {
+			renumber(phone_map);
+		}
+		if constexpr (Policy::full_text_index) {
+			renumber(full_text_map);
+		}
+		index_generation++;
+	}
+
+	if (added_count == 0) {
+		return Status::Ok;
+	}
+
+	// Append the added entries
+	size_t first_added = entries.size();
+	entries.reserve(entries.size() + added_count);
+	fingerprints.reserve(fingerprints.size() + added_count);
+	reserveFilters(entries.size() + added_count);
+	for (Touched& entry : touched) {
+		if (entry.book_index == no_entry && entry.present) {
+			recordChange(ChangeType::Added, entry.entry.toEntry());
+			invalidateFindCache(entry.entry.firstNameFolded());
+			invalidateFindCache(entry.entry.lastNameFolded());
+			entries.push_back(std::move(entry.entry));
+			fingerprints.push_back(entry.fingerprint);
+			filterEntry(entries.size() - 1);
+		}
+	}
+
+	// Collect the index keys of the added entries and sort them by map and key
+	std::pmr::vector<IndexKey> keys(resource);
+	for (size_t i = first_added; i < entries.size(); i++) {
+		visitIndexKeys(i, resource, [&keys, i](NameMap& map, std::pmr::string key) {
+			keys.push_back({ &map, std::move(key), i });
+		});
+	}
+	std::sort(keys.begin(), keys.end());
+
+	mergeIndexKeys(keys);
+	return Status::Ok;
+}
+
+
+template <typename Policy>
+void BasicAddressBook<Policy>::mergeIndexKeys(std::span<IndexKey> keys)
+{
+	NameMap* map = nullptr;
+	typename NameMap::iterator hint;
+	for (size_t i = 0; i < keys.size();) {
+		if (keys[i].map != map) {
+			map = keys[i].map;
+			hint = map->begin();
+		}
+
+		auto bucket = map->try_emplace(hint, std::move(keys[i].key));
+
+		// All the entries with this key (new indices are larger than the existing ones so they go at the end)
+		size_t next = i;
+		while (next < keys.size() && keys[next].map == map && (next == i || keys[next].key == bucket->first)) {
+			bucket->second.push_back(keys[next].index);
+			next++;
+		}
+
+		hint = std::next(bucket);
+		i = next;
+	}
+}
+
+
+template <typename Policy>
+typename BasicAddressBook<Policy>::NameMap& BasicAddressBook<Policy>::primaryNameMap()
+{
+	if constexpr (Policy::first_name_index) {
+		return first_name_map;
+	}
+	else {
+		return last_name_map;
+	}
+}
+
+
+template <typename Policy>
+std::vector<AddressBookEntry> BasicAddressBook<Policy>::sortedByFirstName() requires Policy::first_name_index
+{
+	[[maybe_unused]] auto timer = operation_recorder.time(AddressBookOperation::SortedByFirstName);
+
+	// Output vector
+	std::vector<Entry> results;
+
+	// Iterate through the first name map and add all the entries to the output vector
+	// We can do this because the first name map is already sorted by first name (std::map)
+	for (auto it = first_name_map.begin(); it != first_name_map.end(); it++) {
+		for (size_t index : it->second) {
+			results.push_back(entries.at(index).toEntry());
+		}
+	}
+
+	return results;
+}
+
+
+template <typename Policy>
+std::vector<AddressBookEntry> BasicAddressBook<Policy>::sortedByLastName() requires Policy::last_name_index
+{
+	[[maybe_unused]] auto timer = operation_recorder.time(AddressBookOperation::SortedByLastName);
+
+	// Output vector
+	std::vector<Entry> results;
+
+	// Iterate through the last name map and add all the entries to the output vector
+	// We can do this because the last name map is already sorted by last name (std::map)
+	for (auto it = last_name_map.begin(); it != last_name_map.end(); it++) {
+		for (size_t index : it->second) {
+			results.push_back(entries.at(index).toEntry());
+		}
+	}
+
+	return results;
+}
+
+
+template <typename Policy>
+template <typename Results>
+void BasicAddressBook<Policy>::findInto(const std::string& prefix, Results& results, std::pmr::memory_resource* scratch)
+{
+	[[maybe_unused]] auto timer = operation_recorder.time(AddressBookOperation::Find);
+
+	// Lower case the prefix (search term)
+	std::pmr::string prefix_lower(prefix, scratch);
+	Policy::case_folding::fold(prefix_lower);
+
+	// Cache hit, move the prefix to the front of the LRU list and return a copy of the cached results
+	if (find_cache_capacity != 0) {
+		auto cached = find_cache_index.find(prefix_lower);
+		if (cached != find_cache_index.end()) {
+			find_cache_hits++;
+			find_cache_lru.splice(find_cache_lru.begin(), find_cache_lru, cached->second);
+			results.assign(cached->second->second.begin(), cached->second->second.end());
+			return;
+		}
+	}
+
+	// Copy the matching entries to the output vector
+	std::pmr::vector<size_t> indices = findIndices(prefix_lower, scratch);
+	results.reserve(indices.size());
+	for (size_t index : indices) {
+		results.push_back(entries.at(index).toEntry());
+	}
+
+	// Cache is disabled
+	if (find_cache_capacity == 0) {
+		return;
+	}
+
+	// Cache miss, evict the least recently used prefix if the cache is full and cache the new results
+	find_cache_misses++;
+	if (find_cache_lru.size() >= find_cache_capacity) {
+		find_cache_index.erase(find_cache_lru.back().first);
+		find_cache_lru.pop_back();
+	}
+	find_cache_lru.emplace_front(std::piecewise_construct, std::forward_as_tuple(prefix_lower),
+		std::forward_as_tuple(results.begin(), results.end()));
+	find_cache_index[prefix_lower] = find_cache_lru.begin();
+}
+
+
+template <typename Policy>
+std::vector<AddressBookEntry> BasicAddressBook<Policy>::find(const std::string& prefix)
+{
+	// Output vector
+	std::vector<Entry> results;
+
+	// Scratch memory for the query, on the stack unless the query needs more than that
+	std::array<std::byte, 2048> scratch_buffer;
+	std::pmr::monotonic_buffer_resource scratch(scratch_buffer.data(), scratch_buffer.size(), resource);
+
+	findInto(prefix, results, &scratch);
+	return results;
+}
+
+
+template <typename Policy>
+std::pmr::vector<AddressBookEntry> BasicAddressBook<Policy>::find(const std::string& prefix, std::pmr::memory_resource* resource)
+{
+	// Output vector
+	std::pmr::vector<Entry> results(resource);
+
+	findInto(prefix, results, resource);
+	return results;
+}
+
+
+template <typename Policy>
+std::vector<AddressBookEntry> BasicAddressBook<Policy>::findExact(const std::string& name)
+{
+	// Output vector
+	std::vector<Entry> results;
+
+	// Scratch memory for the query, on the stack unless the query needs more than that
+	std::array<std::byte, 512> scratch_buffer;
+	std::pmr::monotonic_buffer_resource scratch(scratch_buffer.data(), scratch_buffer.size(), resource);
+
+	std::pmr::string name_lower(name, &scratch);
+	Policy::case_folding::fold(name_lower);
+
+	// Definitely not a first or last name of any entry
+	if (!name_filter.mayContain(nameHash(name_lower))) {
+		return results;
+	}
+
+	// An entry with the same first and last name is in both maps, only return it once
+	std::pmr::unordered_set<size_t> found_indices(&scratch);
+	auto collect = [&](const NameMap& map) {
+		auto bucket = map.find(name_lower);
+		if (bucket == map.end()) {
+			return;
+		}
+		for (size_t index : bucket->second) {
+			if (found_indices.insert(index).second) {
+				results.push_back(entries.at(index).toEntry());
+			}
+		}
+	};
+	if constexpr (Policy::first_name_index) {
+		collect(first_name_map);
+	}
+	if constexpr (Policy::last_name_index) {
+		collect(last_name_map);
+	}
+
+	return results;
+}
+
+
+template <typename Policy>
+std::pmr::vector<size_t> BasicAddressBook<Policy>::findIndices(const std::pmr::string& prefix_lower, std::pmr::memory_resource* scratch)
+{
+	// Output vector of indices into the entries vector
+	std::pmr::vector<size_t> results(scratch);
+
+	// Set to keep track of found entries
+	// This way we can avoid adding duplicate entries to the output vector. Every entry has its own index so we can
+	// use the indices rather than hashing whole entries
+	std::pmr::unordered_set<size_t> found_indices(scratch);
+
+	// First name matches come first, then any last name matches that weren't already found
+	if constexpr (Policy::first_name_index) {
+		collectPrefixMatches(first_name_map, prefix_lower, results, found_indices);
+	}
+	if constexpr (Policy::last_name_index) {
+		collectPrefixMatches(last_name_map, prefix_lower, results, found_indices);
+	}
+
+	return results;
+}
+
+
+template <typename Policy>
+void BasicAddressBook<Policy>::collectPrefixMatches(const NameMap& map, const std::pmr::string& prefix_lower,
+	std::pmr::vector<size_t>& results, std::pmr::unordered_set<size_t>& found)
+{
+	// Iterate through the map starting at the lower bound (the first key that is >= the prefix) and stop when we reach
+	// the end of the map or the prefix is no longer a prefix of the key
+	for (auto it = map.lower_bound(prefix_lower); it != map.end() && it->first.starts_with(prefix_lower); it++) {
+		// Iterate through the indices returned by the map
+		for (size_t index : it->second) {
+			// Check if the entry is already in the output vector (to avoid adding the same entry twice)
+			if (found.insert(index).second) {
+				results.push_back(index);
+			}
+		}
+	}
+}
+
+
+template <typename Policy>
+std::vector<AddressBookEntry> BasicAddressBook<Policy>::findByPhone(const std::string& prefix) requires Policy::phone_index
+{
+	// Output vector
+	std::vector<Entry> results;
+
+	// Scratch memory for the query, on the stack unless the query needs more than that
+	std::array<std::byte, 2048> scratch_buffer;
+	std::pmr::monotonic_buffer_resource scratch(scratch_buffer.data(), scratch_buffer.size(), resource);
+
+	// A phone number is only indexed once so there are no duplicates to remove
+	std::pmr::unordered_set<size_t> found_indices(&scratch);
+	std::pmr::vector<size_t> indices(&scratch);
+	collectPrefixMatches(phone_map, detail::phoneDigits(prefix, &scratch), indices, found_indices);
+
+	results.reserve(indices.size());
+	for (size_t index : indices) {
+		results.push_back(entries.at(index).toEntry());
+	}
+	return results;
+}
+
+
+template <typename Policy>
+std::vector<AddressBookEntry> BasicAddressBook<Policy>::findFullText(const std::string& prefix) requires Policy::full_text_index
+{
+	// Output vector
+	std::vector<Entry> results;
+
+	// Scratch memory for the query, on the stack unless the query needs more than that
+	std::array<std::byte, 2048> scratch_buffer;
+	std::pmr::monotonic_buffer_resource scratch(scratch_buffer.data(), scratch_buffer.size(), resource);
+
+	// Fold the prefix like the words in the index
+	std::pmr::string prefix_lower(prefix, &scratch);
+	Policy::case_folding::fold(prefix_lower);
+
+	// An entry can have several words matching the prefix, only return it once
+	std::pmr::unordered_set<size_t> found_indices(&scratch);
+	std::pmr::vector<size_t> indices(&scratch);
+	collectPrefixMatches(full_text_map, prefix_lower, indices, found_indices);
+
+	results.reserve(indices.size());
+	for (size_t index : indices) {
+		results.push_back(entries.at(index).toEntry());
+	}
+	return results;
+}
+
+
+template <typename Policy>
+std::vector<typename BasicAddressBook<Policy>::Change> BasicAddressBook<Policy>::changesSince(uint64_t version) const
+{
+	if (version > current_version) {
+		throw std::invalid_argument("Version is newer than the address book");
+	}
+
+	// Number of changes the consumer is missing
+	uint64_t missing = current_version - version;
+
+	// The consumer has fallen behind further than the change feed goes back
+	if (missing > change_feed.size()) {
+		throw std::out_of_range("Changes since version are no longer in the change feed");
+	}
+
+	// Output vector
+	std::vector<Change> results;
+	results.reserve(missing);
+
+	// The missing changes are the newest ones in the buffer, walk them oldest first
+	// The oldest change lives at change_feed_head (0 until the buffer wraps around)
+	size_t start = change_feed_head + (change_feed.size() - missing);
+	for (size_t i = 0; i < missing; i++) {
+		results.push_back(change_feed.at((start + i) % change_feed.size()));
+	}
+
+	return results;
+}
+
+
+template <typename Policy>
+void BasicAddressBook<Policy>::invalidateFindCache(std::string_view name_lower)
+{
+	if (find_cache_index.empty()) {
+		return;
+	}
+
+	// Only prefixes of the name (including the empty prefix and the whole name) can match it
+	for (size_t length = 0; length <= name_lower.size(); length++) {
+		auto cached = find_cache_index.find(std::pmr::string(name_lower.substr(0, length), resource));
+		if (cached != find_cache_index.end()) {
+			find_cache_lru.erase(cached->second);
+			find_cache_index.erase(cached);
+		}
+	}
+}
+
+
+template <typename Policy>
+void BasicAddressBook<Policy>::enableFindCache(size_t capacity)
+{
+	find_cache_capacity = capacity;
+
+	// Evict the least recently used prefixes until we fit in the new capacity
+	while (find_cache_lru.size() > find_cache_capacity) {
+		find_cache_index.erase(find_cache_lru.back().first);
+		find_cache_lru.pop_back();
+	}
+}
+
+
+template <typename Policy>
+typename BasicAddressBook<Policy>::FindCacheStats BasicAddressBook<Policy>::findCacheStats() const
+{
+	return { find_cache_hits, find_cache_misses, find_cache_lru.size(), find_cache_capacity };
+}
+
+
+template <typename Policy>
+AddressBookStats BasicAddressBook<Policy>::stats() const
+{
+	AddressBookStats stats;
+	stats.enabled = OperationRecorder::enabled;
+	operation_recorder.snapshot(stats);
+
+	// Work out the gauges now rather than keeping them up to date on the hot paths
+	stats.entries = entries.size();
+	if constexpr (Policy::first_name_index) {
+		stats.first_name_keys = first_name_map.size();
+		for (auto& [key, indices] : first_name_map) {
+			stats.largest_first_name_bucket = std::max(stats.largest_first_name_bucket, indices.size());
+		}
+	}
+	if constexpr (Policy::last_name_index) {
+		stats.last_name_keys = last_name_map.size();
+		for (auto& [key, indices] : last_name_map) {
+			stats.largest_last_name_bucket = std::max(stats.largest_last_name_bucket, indices.size());
+		}
+	}
+	if constexpr (Policy::phone_index) {
+		stats.phone_keys = phone_map.size();
+	}
+	if constexpr (Policy::full_text_index) {
+		stats.full_text_keys = full_text_map.size();
+	}
+	stats.find_cache_size = find_cache_lru.size();
+
+	return stats;
+}
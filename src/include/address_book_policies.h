@@ -0,0 +1,79 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <memory_resource>
+#include <string>
+
+/*
+* Compile time configuration of the indexes an address book maintains
+*
+* An index policy is a type with the following members:
+*   static constexpr bool first_name_index  Keep a map of first names (needed by sortedByFirstName)
+*   static constexpr bool last_name_index   Keep a map of last names (needed by sortedByLastName)
+*   static constexpr bool phone_index       Keep a map of phone numbers (needed by findByPhone)
+*   static constexpr bool full_text_index   Keep a map of every word in the names (needed by findFullText)
+*   using case_folding                      How names are normalised before they are used as keys
+*
+* find matches on whichever of the first and last name indexes are enabled, at least one of them has to be. Disabled
+* indexes take no memory and aren't touched by add or remove.
+*/
+
+
+/// Case insensitive keys, ASCII letters are lower cased
+struct AsciiCaseFolding
+{
+	static void fold(std::pmr::string& key)
+	{
+		std::transform(key.begin(), key.end(), key.begin(),
+			[](unsigned char c) { return static_cast<char>(::tolower(c)); });
+	}
+};
+
+
+/*
+* @brief Case and accent insensitive keys
+*
+* ASCII letters are lower cased and the accented letters of the Latin-1 range (UTF-8 encoded) are replaced by their
+* plain lower case letter, e.g. "José Núñez" is indexed as "jose nunez". Letters with no plain equivalent (æ, þ, ß) are
+* only lower cased. Anything else is kept as it is.
+*/
+struct AccentStrippingCaseFolding
+{
+	static void fold(std::pmr::string& key);
+};
+
+
+/// Case sensitive keys, names are used as they are
+struct NoCaseFolding
+{
+	static void fold(std::pmr::string&) {}
+};
+
+
+/// Builds an index policy out of the individual switches
+template <bool FirstName, bool LastName, bool Phone, bool FullText, typename CaseFolding = AsciiCaseFolding>
+struct IndexPolicy
+{
+	static constexpr bool first_name_index = FirstName;
+	static constexpr bool last_name_index = LastName;
+	static constexpr bool phone_index = Phone;
+	static constexpr bool full_text_index = FullText;
+	using case_folding = CaseFolding;
+};
+
+
+// First and last name indexes, case insensitive (AddressBook)
+using DefaultIndexPolicy = IndexPolicy<true, true, false, false>;
+
+// Only a last name index, for deployments that never sort by first name
+using LastNameIndexPolicy = IndexPolicy<false, true, false, false>;
+
+// Every index
+using FullIndexPolicy = IndexPolicy<true, true, true, true>;
+
+// First and last name indexes, case sensitive
+using CaseSensitiveIndexPolicy = IndexPolicy<true, true, false, false, NoCaseFolding>;
+
+// First and last name indexes, case and accent insensitive
+using AccentInsensitiveIndexPolicy = IndexPolicy<true, true, false, false, AccentStrippingCaseFolding>;
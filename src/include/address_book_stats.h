@@ -0,0 +1,222 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+/*
+* Optional hot path instrumentation for the address book
+*
+* Instrumentation is only compiled in when ADDRESSBOOK_ENABLE_STATS is defined (see the ADDRESSBOOK_ENABLE_STATS cmake
+* option). When it isn't, OperationRecorder is an empty class and its timers do nothing so the address book pays
+* nothing for it. The gauges (sizes of the entries vector and the maps) are worked out when stats are requested so they
+* are always available.
+*/
+
+/// The operations (and parts of operations) that are timed
+enum class AddressBookOperation
+{
+	Add,
+	// The part of add spent checking for duplicate entries
+	AddDuplicateCheck,
+	Remove,
+	RebuildMaps,
+	Find,
+	SortedByFirstName,
+	SortedByLastName,
+	// Transaction::commit
+	Commit,
+	// The set operations (operator+, operator- and operator& and their pool taking versions)
+	Union,
+	Difference,
+	Intersection,
+	Count
+};
+
+// Number of timed operations
+constexpr size_t address_book_operation_count = static_cast<size_t>(AddressBookOperation::Count);
+
+// Name of an operation as it appears in the stats dumps
+const char* operationName(AddressBookOperation operation);
+
+
+/*
+* @brief A histogram of latencies in nanoseconds with a bounded relative error
+*
+* Like an HDR histogram, values are grouped by their power of two and every power of two is split into sub_bucket_count
+* linear sub buckets, so any recorded value is within 1/sub_bucket_count of the bucket it is counted in. Values from 0 to
+* about a minute fit in a fixed array of counters, anything slower is counted in the last bucket.
+*/
+class LatencyHistogram
+{
+public:
+	// Number of linear sub buckets per power of two (must be a power of two)
+	static constexpr uint64_t sub_bucket_bits = 3;
+	static constexpr uint64_t sub_bucket_count = uint64_t(1) << sub_bucket_bits;
+
+	// Largest power of two tracked (2^36 ns is a bit over a minute)
+	static constexpr uint64_t max_exponent = 36;
+
+	static constexpr size_t bucket_count = sub_bucket_count + (max_exponent - sub_bucket_bits + 1) * sub_bucket_count;
+
+private:
+	std::array<uint64_t, bucket_count> counts{};
+	uint64_t total_count = 0;
+	uint64_t total_ns = 0;
+	uint64_t min_ns = UINT64_MAX;
+	uint64_t max_ns = 0;
+
+	// Index of the bucket a value is counted in
+	static size_t bucketIndex(uint64_t ns);
+
+	// Smallest value counted in a bucket
+	static uint64_t bucketLowerBound(size_t index);
+
+public:
+
+	/*
+	* @brief Count one latency
+	*
+	* @param ns The latency in nanoseconds
+	* @return void
+	*/
+	void record(uint64_t ns);
+
+	/// Number of latencies recorded
+	uint64_t count() const { return total_count; }
+
+	/// Mean latency in nanoseconds (0 if nothing was recorded)
+	double mean() const { return total_count == 0 ? 0.0 : static_cast<double>(total_ns) / total_count; }
+
+	/// Smallest latency in nanoseconds (0 if nothing was recorded)
+	uint64_t min() const { return total_count == 0 ? 0 : min_ns; }
+
+	/// Largest latency in nanoseconds
+	uint64_t max() const { return max_ns; }
+
+	/*
+	* @brief Return the latency below which the given fraction of recorded latencies fall
+	*
+	* The result is the lower bound of the bucket the percentile lands in, so it is accurate to within one sub bucket.
+	*
+	* @param fraction The percentile as a fraction, e.g. 0.99 for p99
+	* @return uint64_t The latency in nanoseconds (0 if nothing was recorded)
+	*/
+	uint64_t percentile(double fraction) const;
+};
+
+
+/// Call count and latencies of one operation
+struct OperationStats
+{
+	uint64_t calls = 0;
+	LatencyHistogram latency;
+};
+
+
+/*
+* @brief A snapshot of the instrumentation of an address book
+*
+* Returned by AddressBook::stats. The operation stats are only filled in when instrumentation is compiled in (enabled
+* is true), the gauges are always filled in.
+*/
+struct AddressBookStats
+{
+	// Whether the library was built with ADDRESSBOOK_ENABLE_STATS
+	bool enabled = false;
+
+	std::array<OperationStats, address_book_operation_count> operations{};
+
+	// Gauges
+	size_t entries = 0;
+	size_t first_name_keys = 0;
+	size_t last_name_keys = 0;
+	// Number of entries sharing the most common first and last name (the longest index vectors in the maps)
+	size_t largest_first_name_bucket = 0;
+	size_t largest_last_name_bucket = 0;
+	// Number of keys in the phone and full text indexes (0 if the policy disables them)
+	size_t phone_keys = 0;
+	size_t full_text_keys = 0;
+	// Number of prefixes in the find cache
+	size_t find_cache_size = 0;
+
+	/// Stats of one operation
+	const OperationStats& operation(AddressBookOperation op) const { return operations.at(static_cast<size_t>(op)); }
+
+	/// Number of times the maps were rebuilt
+	uint64_t rebuilds() const { return operation(AddressBookOperation::RebuildMaps).calls; }
+
+	/*
+	* @brief Write the stats as human readable text, one line per gauge and operation
+	*
+	* @param os The stream to write to
+	* @return void
+	*/
+	void writeText(std::ostream& os) const;
+
+	/*
+	* @brief Write the stats as a single JSON object
+	*
+	* @param os The stream to write to
+	* @return void
+	*/
+	void writeJson(std::ostream& os) const;
+};
+
+
+/*
+* @brief Records call counts and latencies of address book operations
+*
+* Usage: auto timer = recorder.time(AddressBookOperation::Add); at the top of the code being timed. The latency is
+* recorded when the timer goes out of scope (including when an exception is thrown).
+*/
+class OperationRecorder
+{
+#ifdef ADDRESSBOOK_ENABLE_STATS
+	std::array<OperationStats, address_book_operation_count> operations{};
+
+public:
+	/// Times a scope and records its latency on destruction
+	class Timer
+	{
+		OperationStats& stats;
+		std::chrono::steady_clock::time_point start;
+
+	public:
+		explicit Timer(OperationStats& stats) : stats(stats), start(std::chrono::steady_clock::now()) {}
+		~Timer()
+		{
+			auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+			stats.calls++;
+			stats.latency.record(static_cast<uint64_t>(elapsed.count()));
+		}
+
+		Timer(const Timer&) = delete;
+		Timer& operator=(const Timer&) = delete;
+	};
+
+	static constexpr bool enabled = true;
+
+	[[nodiscard]] Timer time(AddressBookOperation op) { return Timer(operations.at(static_cast<size_t>(op))); }
+
+	/// Copy the recorded operation stats into a snapshot
+	void snapshot(AddressBookStats& stats) const { stats.operations = operations; }
+
+	/// Forget everything recorded so far
+	void reset() { operations = {}; }
+#else
+public:
+	/// Does nothing, instrumentation is compiled out
+	struct Timer {};
+
+	static constexpr bool enabled = false;
+
+	[[nodiscard]] Timer time(AddressBookOperation) { return {}; }
+
+	void snapshot(AddressBookStats&) const {}
+
+	void reset() {}
+#endif
+};
@@ -0,0 +1,133 @@
+#pragma once
+
+#include "address_book.h"
+#include "async_task.h"
+#include "work_queue.h"
+
+#include <string>
+#include <vector>
+#include <mutex>
+
+/*
+* @brief A coroutine front end that runs address book queries on an internal work queue
+*
+* Meant for event loop servers: co_await book.findAsync(prefix) suspends the calling coroutine while the query runs on
+* one of the queue's workers instead of blocking the loop. Sorted listings are produced as async generators yielding
+* chunks of entries, each chunk is a separate job on the queue so a large listing doesn't hold up other queries
+* between chunks.
+*
+* Awaiting coroutines are resumed on the worker thread that produced the result. Queries (and add and remove made
+* through the front end) are serialised with a lock; while a front end is in use the address book must only be changed
+* through it, and it must outlive the front end.
+*/
+class AsyncAddressBook
+{
+public:
+	using Entry = AddressBook::Entry;
+
+	// Number of entries per chunk of a sorted listing when no chunk size is given
+	static constexpr size_t default_chunk_size = 1024;
+
+private:
+	using NameMap = AddressBook::NameMap;
+
+	// The address book being queried
+	AddressBook& book;
+
+	// Guards book, queries running on different workers take turns
+	std::mutex mutex;
+
+	// Declared last so the workers stop (finishing the queued jobs) before the members above are destroyed
+	WorkQueue queue;
+
+	/*
+	* Method to list the entries of the book in the order of one of its name maps, chunk_size entries at a time
+	*
+	* Between chunks the listing only remembers the key it got up to (and how far into that key's entries), so other
+	* queries and changes can run in between. Entries added or removed during a listing may or may not be included.
+	*/
+	AsyncGenerator<std::vector<Entry>> listAsync(NameMap AddressBook::* names, size_t chunk_size);
+
+public:
+
+	/*
+	* @brief Create a front end for book with its own worker threads
+	*
+	* @param book The address book to query
+	* @param worker_count The number of worker threads running queries
+	* @throws std::invalid_argument if worker_count is 0
+	*/
+	explicit AsyncAddressBook(AddressBook& book, size_t worker_count = 1);
+
+	// The workers refer to the front end so it can't be copied
+	AsyncAddressBook(const AsyncAddressBook&) = delete;
+	AsyncAddressBook& operator=(const AsyncAddressBook&) = delete;
+
+
+	/*
+	* @brief Return all entries that match the prefix (case insensitive), see AddressBook::find
+	*
+	* @param prefix The prefix to match (taken by value, the query runs after the caller has moved on)
+	* @return Task<std::vector<AddressBook::Entry>> A task producing the matching entries when awaited
+	*/
+	Task<std::vector<Entry>> findAsync(std::string prefix);
+
+
+	/*
+	* @brief Return all entries sorted by first name, in chunks
+	*
+	* @param chunk_size The maximum number of entries per chunk (the last chunk may be smaller)
+	* @return AsyncGenerator<std::vector<AddressBook::Entry>> A generator yielding the chunks in order
+	* @throws std::invalid_argument if chunk_size is 0
+	*/
+	AsyncGenerator<std::vector<Entry>> sortedByFirstNameAsync(size_t chunk_size = default_chunk_size);
+
+
+	/*
+	* @brief Return all entries sorted by last name, in chunks
+	*
+	* @param chunk_size The maximum number of entries per chunk (the last chunk may be smaller)
+	* @return AsyncGenerator<std::vector<AddressBook::Entry>> A generator yielding the chunks in order
+	* @throws std::invalid_argument if chunk_size is 0
+	*/
+	AsyncGenerator<std::vector<Entry>> sortedByLastNameAsync(size_t chunk_size = default_chunk_size);
+
+
+	/*
+	* @brief Add a person to the address book (under the front end's lock), see AddressBook::add
+	*
+	* @param person The person to add
+	* @throws std::invalid_argument if the entry does not have a first or last name or already exists
+	* @return void
+	*/
+	void add(const Entry& person);
+
+
+	/*
+	* @brief Remove a person from the address book (under the front end's lock), see AddressBook::remove
+	*
+	* @param person The person to remove
+	* @throws std::invalid_argument if the entry does not exist
+	* @return void
+	*/
+	void remove(const Entry& person);
+
+
+	/*
+	* @brief Add a person to the address book (under the front end's lock), see AddressBook::tryAdd
+	*
+	* @param person The person to add
+	* @return AddressBook::Status Ok, MissingName, FieldTooLong or AlreadyExists
+	*/
+	[[nodiscard]] AddressBook::Status tryAdd(const Entry& person);
+
+
+	/*
+	* @brief Remove a person from the address book (under the front end's lock), see AddressBook::tryRemove
+	*
+	* @param person The person to remove
+	* @return AddressBook::Status Ok, FieldTooLong or NotFound
+	*/
+	[[nodiscard]] AddressBook::Status tryRemove(const Entry& person);
+
+};
@@ -0,0 +1,243 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <future>
+#include <memory>
+#include <optional>
+#include <utility>
+
+/*
+* Coroutine types used by the asynchronous address book front end
+*
+* Task<T> is a lazily started coroutine producing one value, AsyncGenerator<T> is a lazily started coroutine producing
+* a sequence of values. Both resume whoever is waiting on them directly (symmetric transfer) so the waiter continues on
+* the thread that produced the value. syncWait blocks a thread that isn't a coroutine until a task has finished.
+*/
+
+
+/*
+* @brief A coroutine that produces a single value of type T when awaited
+*
+* The body doesn't start until the task is awaited. Exceptions thrown by the body are rethrown by co_await.
+*/
+template <typename T>
+class Task
+{
+public:
+	struct promise_type
+	{
+		std::optional<T> value;
+		std::exception_ptr exception;
+		std::coroutine_handle<> continuation = std::noop_coroutine();
+
+		Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+		std::suspend_always initial_suspend() noexcept { return {}; }
+
+		// Resume the awaiting coroutine once the body has finished
+		struct FinalAwaiter
+		{
+			bool await_ready() const noexcept { return false; }
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+			{
+				return handle.promise().continuation;
+			}
+			void await_resume() const noexcept {}
+		};
+
+		FinalAwaiter final_suspend() noexcept { return {}; }
+		void return_value(T result) { value.emplace(std::move(result)); }
+		void unhandled_exception() { exception = std::current_exception(); }
+	};
+
+private:
+	std::coroutine_handle<promise_type> handle;
+
+	explicit Task(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+public:
+	Task(Task&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+	Task& operator=(Task&& other) noexcept
+	{
+		if (this != &other) {
+			if (handle) {
+				handle.destroy();
+			}
+			handle = std::exchange(other.handle, nullptr);
+		}
+		return *this;
+	}
+	~Task()
+	{
+		if (handle) {
+			handle.destroy();
+		}
+	}
+
+	// Awaiting the task starts the body, the awaiting coroutine is resumed when it finishes
+	bool await_ready() const noexcept { return false; }
+	std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) noexcept
+	{
+		handle.promise().continuation = continuation;
+		return handle;
+	}
+	T await_resume()
+	{
+		if (handle.promise().exception) {
+			std::rethrow_exception(handle.promise().exception);
+		}
+		return std::move(*handle.promise().value);
+	}
+};
+
+
+/*
+* @brief A coroutine that produces a sequence of values of type T, one per co_yield
+*
+* Usage: while (std::optional<T> value = co_await generator.next()) { ... }
+* next() resumes the body until its next co_yield (or until it finishes, then next() gives std::nullopt). Exceptions
+* thrown by the body are rethrown by co_await generator.next(). Only one next() may be pending at a time, and the
+* generator must not be destroyed while one is.
+*/
+template <typename T>
+class AsyncGenerator
+{
+public:
+	struct promise_type
+	{
+		std::optional<T> current;
+		std::exception_ptr exception;
+		std::coroutine_handle<> consumer = std::noop_coroutine();
+
+		AsyncGenerator get_return_object() { return AsyncGenerator(std::coroutine_handle<promise_type>::from_promise(*this)); }
+		std::suspend_always initial_suspend() noexcept { return {}; }
+
+		// Hand control back to the coroutine waiting in next(), used for co_yield and when the body finishes
+		struct YieldAwaiter
+		{
+			bool await_ready() const noexcept { return false; }
+			std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+			{
+				return handle.promise().consumer;
+			}
+			void await_resume() const noexcept {}
+		};
+
+		YieldAwaiter yield_value(T value)
+		{
+			current.emplace(std::move(value));
+			return {};
+		}
+		YieldAwaiter final_suspend() noexcept { return {}; }
+		void return_void() {}
+		void unhandled_exception() { exception = std::current_exception(); }
+	};
+
+	/// Awaitable returned by next()
+	class NextAwaiter
+	{
+		std::coroutine_handle<promise_type> handle;
+
+	public:
+		explicit NextAwaiter(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+		bool await_ready() const noexcept { return handle.done(); }
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<> consumer) noexcept
+		{
+			handle.promise().consumer = consumer;
+			handle.promise().current.reset();
+			return handle;
+		}
+		std::optional<T> await_resume()
+		{
+			promise_type& promise = handle.promise();
+			if (promise.exception) {
+				std::rethrow_exception(std::exchange(promise.exception, nullptr));
+			}
+			if (handle.done()) {
+				return std::nullopt;
+			}
+			return std::move(promise.current);
+		}
+	};
+
+private:
+	std::coroutine_handle<promise_type> handle;
+
+	explicit AsyncGenerator(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+public:
+	AsyncGenerator(AsyncGenerator&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+	AsyncGenerator& operator=(AsyncGenerator&& other) noexcept
+	{
+		if (this != &other) {
+			if (handle) {
+				handle.destroy();
+			}
+			handle = std::exchange(other.handle, nullptr);
+		}
+		return *this;
+	}
+	~AsyncGenerator()
+	{
+		if (handle) {
+			handle.destroy();
+		}
+	}
+
+	/*
+	* @brief Return an awaitable producing the next value, or std::nullopt once the generator has finished
+	*
+	* @return NextAwaiter The awaitable
+	*/
+	NextAwaiter next() { return NextAwaiter(handle); }
+};
+
+
+namespace detail
+{
+	/// A coroutine that starts straight away and frees itself when it finishes, nobody waits on it
+	struct DetachedTask
+	{
+		struct promise_type
+		{
+			DetachedTask get_return_object() { return {}; }
+			std::suspend_never initial_suspend() noexcept { return {}; }
+			std::suspend_never final_suspend() noexcept { return {}; }
+			void return_void() {}
+			void unhandled_exception() { std::terminate(); }
+		};
+	};
+
+	template <typename T>
+	DetachedTask completeInto(Task<T> task, std::shared_ptr<std::promise<T>> result)
+	{
+		try {
+			result->set_value(co_await task);
+		}
+		catch (...) {
+			result->set_exception(std::current_exception());
+		}
+	}
+}
+
+
+/*
+* @brief Run a task and block the calling thread until it has finished
+*
+* For threads that aren't coroutines themselves (tests, main). Must not be called from a thread the task needs to make
+* progress, e.g. a worker of the work queue it runs on.
+*
+* @param task The task to run
+* @return T The value produced by the task
+* @throws Whatever the task throws
+*/
+template <typename T>
+T syncWait(Task<T> task)
+{
+	// The promise is shared with the coroutine so it stays alive until the coroutine is done with it
+	auto result = std::make_shared<std::promise<T>>();
+	std::future<T> future = result->get_future();
+	detail::completeInto(std::move(task), result);
+	return future.get();
+}
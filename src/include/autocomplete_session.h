@@ -0,0 +1,113 @@
+#pragma once
+
+#include "address_book.h"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/*
+* @brief A stateful prefix search over an address book for autocomplete
+*
+* Rather than calling AddressBook::find from scratch for every keystroke, the session keeps the range of first name and
+* last name map keys that match the current prefix, one range per prefix length. Typing a character narrows the last
+* range, backspace just drops it. Suggestions are only produced for the top max_suggestions entries, so a keystroke
+* costs the number of keys it drops from the range (at most a couple of map lookups) plus the suggestions returned,
+* no matter how many entries match a short prefix.
+*
+* Note: The session keeps iterators into the address book maps. It notices entries being added or removed (using the
+* address book version) and the maps being rebuilt or reassigned (using their index generation) and recomputes its
+* ranges, but it must not outlive the address book.
+*/
+class AutocompleteSession
+{
+public:
+	using Entry = AddressBook::Entry;
+
+private:
+	using NameMap = AddressBook::NameMap;
+
+	/// The keys of the first and last name maps that match a prefix, as [begin, end) ranges
+	struct Range
+	{
+		NameMap::const_iterator first_name_begin;
+		NameMap::const_iterator first_name_end;
+		NameMap::const_iterator last_name_begin;
+		NameMap::const_iterator last_name_end;
+	};
+
+	// The address book being searched
+	const AddressBook& book;
+
+	// Maximum number of suggestions to return
+	size_t max_suggestions;
+
+	// The lower case prefix typed so far
+	std::string prefix_lower;
+
+	// ranges[i] is the range matching the first i characters of the prefix, ranges[0] covers the whole address book
+	std::vector<Range> ranges;
+
+	// Version and index generation of the address book the ranges were computed at
+	uint64_t synced_version;
+	uint64_t synced_index_generation;
+
+	/*
+	* Method to compute the range matching the first length characters of the prefix
+	*
+	* Narrows ranges[length - 1] by walking its bounds in past the keys that no longer match
+	*/
+	Range narrow(size_t length) const;
+
+	/*
+	* Method to recompute every range if the address book changed since they were computed
+	*/
+	void resyncIfChanged();
+
+public:
+
+	/*
+	* @brief Start a session with an empty prefix
+	*
+	* @param book The address book to search
+	* @param max_suggestions The maximum number of suggestions returned by suggestions()
+	*/
+	AutocompleteSession(const AddressBook& book, size_t max_suggestions);
+
+
+	/*
+	* @brief Append characters to the prefix
+	*
+	* @param text The characters typed
+	* @return void
+	*/
+	void type(const std::string& text);
+
+
+	/*
+	* @brief Remove the last character of the prefix (does nothing if the prefix is empty)
+	*
+	* @return void
+	*/
+	void backspace();
+
+
+	/*
+	* @brief Return the prefix typed so far (lower case)
+	*
+	* @return const std::string& The current prefix
+	*/
+	const std::string& prefix() const { return prefix_lower; }
+
+
+	/*
+	* @brief Return the top suggestions for the current prefix
+	*
+	* Entries whose first or last name starts with the prefix (case insensitive), ranked by the matching name in
+	* alphabetical order. An entry matching on both names is only returned once.
+	*
+	* @return std::vector<AddressBook::Entry> At most max_suggestions matching entries
+	*/
+	std::vector<Entry> suggestions();
+
+};
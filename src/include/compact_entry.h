@@ -0,0 +1,191 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+
+struct AddressBookEntry;
+
+/*
+* @brief The fixed size form of an address book entry used inside the address book
+*
+* The first name, last name and phone number are packed back to back, followed by the case folded first and last names
+* the entry is indexed under. Their lengths are kept in a small header. When everything fits (the usual case, names and
+* phone numbers are short) the bytes live inline and an entry is a single 64 byte block with no heap allocation, versus
+* three std::strings (96 bytes plus any heap blocks) for AddressBookEntry. Longer entries spill the bytes to a block
+* allocated from the memory resource the entry was constructed with, which is remembered next to the block.
+*
+* Like the std::pmr containers, a std::pmr::vector of entries constructs them with its own memory resource, and an
+* assignment never moves the spilled block of an entry to another resource. An entry that isn't spilled doesn't
+* remember its resource, so a copy assigned to it spills to the default resource.
+*
+* Since the three fields are contiguous two entries are equal when their field lengths and one memcmp of the packed
+* bytes match.
+*/
+class CompactEntry
+{
+public:
+	// Lets std::pmr containers pass their memory resource to the entries they construct
+	using allocator_type = std::pmr::polymorphic_allocator<>;
+
+	// Total size of a compact entry
+	static constexpr size_t size = 64;
+
+	// Longest field that can be stored
+	static constexpr size_t max_field_length = UINT16_MAX;
+
+private:
+	// Lengths of the fields, in the order they are packed
+	enum Field { FirstName, LastName, PhoneNumber, FirstNameFolded, LastNameFolded, FieldCount };
+
+	// Bytes available inline, what's left of the 64 bytes after the header
+	static constexpr size_t inline_capacity = size - FieldCount * sizeof(uint16_t) - sizeof(uint16_t);
+
+	uint16_t lengths[FieldCount];
+
+	// Whether the packed bytes are on the heap rather than inline
+	uint16_t spilled;
+
+	// The packed bytes, or when they are spilled a pointer to them followed by the resource they were allocated from
+	// Kept as plain bytes (the pointers are memcpy'd in and out) so the header doesn't need padding
+	char storage[inline_capacity];
+
+	char* heapBytes() const
+	{
+		char* heap_bytes;
+		std::memcpy(&heap_bytes, storage, sizeof(heap_bytes));
+		return heap_bytes;
+	}
+
+	std::pmr::memory_resource* heapResource() const
+	{
+		std::pmr::memory_resource* resource;
+		std::memcpy(&resource, storage + sizeof(char*), sizeof(resource));
+		return resource;
+	}
+
+	void setHeap(char* heap_bytes, std::pmr::memory_resource* resource)
+	{
+		std::memcpy(storage, &heap_bytes, sizeof(heap_bytes));
+		std::memcpy(storage + sizeof(char*), &resource, sizeof(resource));
+	}
+
+	// Offset of a field in the packed bytes
+	size_t offset(Field field) const
+	{
+		size_t result = 0;
+		for (int i = 0; i < field; i++) {
+			result += lengths[i];
+		}
+		return result;
+	}
+
+	// Total number of packed bytes
+	size_t packedSize() const { return offset(FieldCount); }
+
+	// Number of packed bytes taken by the three fields of the entry (the folded names come after them)
+	size_t entrySize() const { return offset(FirstNameFolded); }
+
+	const char* bytes() const { return spilled ? heapBytes() : storage; }
+
+	std::string_view field(Field which) const { return std::string_view(bytes() + offset(which), lengths[which]); }
+
+	// Copy the header and storage of other as they are (shares the heap block if there is one)
+	void copyBits(const CompactEntry& other) noexcept;
+
+	// Copy the packed bytes of other, allocating a heap block from resource if they don't fit inline
+	void copyFrom(const CompactEntry& other, std::pmr::memory_resource* resource);
+
+	// Take over the packed bytes of other, which is left empty, copying them if they are spilled to another resource
+	void takeFrom(CompactEntry& other, std::pmr::memory_resource* resource);
+
+	// Free the heap block if there is one
+	void release() noexcept;
+
+public:
+
+	/*
+	* @brief Construct an entry with every field empty, e.g. as a place to assign an entry to later (never allocates)
+	*/
+	explicit CompactEntry(const allocator_type& = {}) noexcept : lengths{}, spilled(0), storage{} {}
+
+
+	/*
+	* @brief Pack an entry along with the case folded names it is indexed under
+	*
+	* @param entry The entry to pack
+	* @param first_name_folded The case folded first name
+	* @param last_name_folded The case folded last name
+	* @param allocator Where to allocate the packed bytes if they don't fit inline (the default resource if not given)
+	* @throws std::length_error if a field is longer than max_field_length (see fits)
+	*/
+	CompactEntry(const AddressBookEntry& entry, std::string_view first_name_folded, std::string_view last_name_folded,
+		const allocator_type& allocator = {});
+
+	CompactEntry(const CompactEntry& other, const allocator_type& allocator = {}) { copyFrom(other, allocator.resource()); }
+	CompactEntry(CompactEntry&& other) noexcept;
+	CompactEntry(CompactEntry&& other, const allocator_type& allocator) { takeFrom(other, allocator.resource()); }
+	CompactEntry& operator=(const CompactEntry& other);
+	CompactEntry& operator=(CompactEntry&& other);
+	~CompactEntry() { release(); }
+
+	/*
+	* @brief Return whether fields of these lengths can be packed, i.e. none is longer than max_field_length
+	*
+	* @param fields The fields to check
+	* @return bool true if the constructor won't throw std::length_error for them
+	*/
+	static bool fits(std::initializer_list<std::string_view> fields)
+	{
+		for (std::string_view field : fields) {
+			if (field.size() > max_field_length) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	std::string_view firstName() const { return field(FirstName); }
+	std::string_view lastName() const { return field(LastName); }
+	std::string_view phoneNumber() const { return field(PhoneNumber); }
+
+	/// The case folded names the entry is indexed under
+	std::string_view firstNameFolded() const { return field(FirstNameFolded); }
+	std::string_view lastNameFolded() const { return field(LastNameFolded); }
+
+	/*
+	* @brief Return a 64-bit hash of the names and phone number
+	*
+	* Equal entries have equal fingerprints, so comparing stored fingerprints rules out almost every unequal entry
+	* without touching the entries themselves.
+	*
+	* @return uint64_t The fingerprint
+	*/
+	uint64_t fingerprint() const;
+
+	/*
+	* @brief Return the fingerprint an entry will have once it is packed, without packing it
+	*
+	* Lets a lookup check its fingerprint (e.g. against a Bloom filter) before folding any names. Doesn't allocate.
+	*
+	* @param entry The entry to fingerprint
+	* @return uint64_t The same fingerprint as CompactEntry(entry, ...).fingerprint()
+	*/
+	static uint64_t fingerprint(const AddressBookEntry& entry);
+
+	/// Unpack into the public entry type
+	AddressBookEntry toEntry() const;
+
+	/// Whether the names and phone numbers of both entries are equal (the folded names follow from them)
+	friend bool operator==(const CompactEntry& lhs, const CompactEntry& rhs)
+	{
+		return std::memcmp(lhs.lengths, rhs.lengths, FirstNameFolded * sizeof(uint16_t)) == 0
+			&& std::memcmp(lhs.bytes(), rhs.bytes(), lhs.entrySize()) == 0;
+	}
+};
+
+static_assert(sizeof(CompactEntry) == CompactEntry::size, "CompactEntry should be exactly 64 bytes");
@@ -0,0 +1,280 @@
+#pragma once
+
+#include "address_book.h"
+
+#include <cstdint>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+/*
+* @brief A sorted list of strings stored front coded
+*
+* Strings are grouped in blocks of block_size. The first string of a block is stored whole, every other one as the
+* length of the prefix it shares with the string before it plus the rest of its bytes, so sorted names with long common
+* prefixes take a fraction of their plain size. Getting a string back decodes at most block_size strings of its block.
+*/
+class FrontCodedDictionary
+{
+public:
+	// Strings per block
+	static constexpr size_t block_size = 16;
+
+private:
+	// Every string as varint shared prefix length, varint suffix length and the suffix bytes
+	std::vector<char> data;
+
+	// Offset in data of the first string of every block
+	std::vector<uint32_t> block_offsets;
+
+	size_t count = 0;
+
+	// The first string of a block, which is stored whole
+	std::string_view blockHead(size_t block) const;
+
+public:
+	FrontCodedDictionary() = default;
+
+	/*
+	* @brief Front code a list of strings
+	*
+	* Any order works but the strings only share prefixes with their neighbours, so sorted strings compress best.
+	*
+	* @param strings The strings to store, a string's id is its position in the list
+	* @throws std::length_error if the coded strings take more than 4GB
+	*/
+	explicit FrontCodedDictionary(const std::vector<std::string_view>& strings);
+
+
+	/*
+	* @brief Return the string with the given id
+	*
+	* @param id The position of the string in the list the dictionary was built from
+	* @return std::string The decoded string
+	*/
+	std::string at(size_t id) const;
+
+
+	/*
+	* @brief Return the id of the first string that is not less than value, for a dictionary built from sorted strings
+	*
+	* Binary searches the first strings of the blocks (which are stored whole so they are compared in place) and then
+	* decodes at most one block, so nothing is allocated unless a string is too long for the small string buffer.
+	*
+	* @param value The string to look for
+	* @return size_t The id of the first string >= value, or size() if every string is less than value
+	*/
+	size_t lowerBound(std::string_view value) const;
+
+
+	/*
+	* @brief Return the number of strings
+	*
+	* @return size_t The number of strings
+	*/
+	size_t size() const { return count; }
+
+
+	/*
+	* @brief Return the memory taken by the coded strings
+	*
+	* @return size_t The size in bytes
+	*/
+	size_t memoryUsage() const { return data.capacity() + block_offsets.capacity() * sizeof(uint32_t); }
+};
+
+
+/*
+* @brief A list of phone numbers packed two characters per byte
+*
+* Phone numbers are digits and a handful of separators, so each character is coded in 4 bits (see alphabet) and
+* a number ends with a terminator nibble. The odd number with a character outside the alphabet is kept as it is.
+*/
+class PackedPhoneNumbers
+{
+public:
+	// The characters that can be packed, a character's code is its position
+	static constexpr std::string_view alphabet = "0123456789 +()-";
+
+private:
+	// Code of the nibble ending a number
+	static constexpr uint8_t terminator = 0xF;
+
+	// Set in an offset when the number is in unpacked rather than in nibbles
+	static constexpr uint32_t unpacked_flag = uint32_t(1) << 31;
+
+	std::vector<uint8_t> nibbles;
+
+	// Byte offset of every number in nibbles (or its position in unpacked, with unpacked_flag set)
+	std::vector<uint32_t> offsets;
+
+	std::vector<std::string> unpacked;
+
+public:
+
+	/*
+	* @brief Add a phone number to the end of the list
+	*
+	* @param phone_number The phone number
+	* @throws std::length_error if the packed numbers take more than 2GB
+	* @return void
+	*/
+	void push_back(std::string_view phone_number);
+
+
+	/*
+	* @brief Return the phone number at index
+	*
+	* @param index The position of the number in the list
+	* @return std::string The unpacked phone number
+	*/
+	std::string at(size_t index) const;
+
+
+	/*
+	* @brief Return the memory taken by the packed numbers
+	*
+	* @return size_t The size in bytes
+	*/
+	size_t memoryUsage() const;
+};
+
+
+/*
+* @brief A read only, compressed snapshot of an address book for very large books
+*
+* First and last names repeat a lot across entries, so every distinct name is stored once in a front coded dictionary
+* (sorted by its case folded key) and entries only keep the ids of their names. Phone numbers are packed two characters
+* per byte. The distinct folded keys get a front coded dictionary of their own and for every key the snapshot keeps the
+* ids of the entries with that key (in the order of the address book), which stands in for the name maps: find binary
+* searches the keys without folding or decoding any names, and only the entries returned are decoded. Results are the
+* same, in the same order, as the address book the snapshot was taken of.
+*
+* The snapshot is immutable. Take a new one to pick up changes to the address book.
+*/
+class CompressedAddressBook
+{
+public:
+	using Entry = AddressBook::Entry;
+
+private:
+	/// One of the two names of an entry
+	struct NameColumn
+	{
+		// Every distinct name, sorted by folded key and then by the name itself
+		FrontCodedDictionary names;
+
+		// Every distinct folded key, sorted, as folded when the entries were added so lookups never fold a name again
+		FrontCodedDictionary keys;
+
+		// Id of the first name of every folded key (names of the same key are next to each other), plus names.size()
+		std::vector<uint32_t> key_starts;
+
+		// The entries with every folded key, ascending: entries key_offsets[key] to key_offsets[key + 1] of key_entries
+		std::vector<uint32_t> key_offsets;
+		std::vector<uint32_t> key_entries;
+
+		// Name id of every entry
+		std::vector<uint32_t> entry_names;
+
+		/*
+		* Method to return the ids of the keys starting with the folded prefix, as a [begin, end) range
+		*/
+		std::pair<size_t, size_t> prefixRange(const std::string& prefix_lower) const;
+
+		size_t keyCount() const { return keys.size(); }
+
+		size_t memoryUsage() const;
+	};
+
+	NameColumn first_names;
+	NameColumn last_names;
+	PackedPhoneNumbers phone_numbers;
+	size_t entry_count = 0;
+
+	/*
+	* Method to store one name of every entry, names[i] being the name of entry i and names_lower its folded key
+	*/
+	static NameColumn buildColumn(const std::vector<std::string_view>& names, const std::vector<std::string_view>& names_lower);
+
+	/// The names decoded last, results are grouped by name so the next entry often has the same ones
+	struct DecodeCache
+	{
+		uint32_t first_name_id = UINT32_MAX;
+		uint32_t last_name_id = UINT32_MAX;
+		std::string first_name;
+		std::string last_name;
+	};
+
+	/*
+	* Method to decode the entry with the given id, only decoding names that aren't in cache
+	*/
+	Entry decode(size_t entry, DecodeCache& cache) const;
+
+	/*
+	* Method to add the ids of the entries whose key in column starts with the folded prefix to results
+	*
+	* Entries already in found are skipped, every id added is marked in found.
+	*/
+	static void collectPrefixMatches(const NameColumn& column, const std::string& prefix_lower,
+		std::pmr::vector<uint32_t>& results, std::pmr::unordered_set<uint32_t>& found);
+
+	/*
+	* Method to list every entry in the key order of column
+	*/
+	std::vector<Entry> listSorted(const NameColumn& column) const;
+
+public:
+
+	/*
+	* @brief Take a compressed snapshot of an address book
+	*
+	* @param book The address book to compress
+	* @throws std::length_error if the address book has 2^32 entries or more
+	*/
+	explicit CompressedAddressBook(const AddressBook& book);
+
+
+	/*
+	* @brief Return the number of entries
+	*
+	* @return size_t The number of entries
+	*/
+	size_t size() const { return entry_count; }
+
+
+	/*
+	* @brief Return all entries that match the prefix (case insensitive), see AddressBook::find
+	*
+	* @param prefix The prefix to match
+	* @return std::vector<AddressBook::Entry> The entries that match the prefix
+	*/
+	std::vector<Entry> find(const std::string& prefix) const;
+
+
+	/*
+	* @brief Return all entries sorted by first name, see AddressBook::sortedByFirstName
+	*
+	* @return std::vector<AddressBook::Entry> The entries sorted by first name
+	*/
+	std::vector<Entry> sortedByFirstName() const { return listSorted(first_names); }
+
+
+	/*
+	* @brief Return all entries sorted by last name, see AddressBook::sortedByLastName
+	*
+	* @return std::vector<AddressBook::Entry> The entries sorted by last name
+	*/
+	std::vector<Entry> sortedByLastName() const { return listSorted(last_names); }
+
+
+	/*
+	* @brief Return the memory taken by the snapshot
+	*
+	* @return size_t The size in bytes
+	*/
+	size_t memoryUsage() const;
+};
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+/*
+* @brief A counting Bloom filter over 64 bit hashes, answering "definitely not there" or "maybe there"
+*
+* Every key sets hash_count 4 bit counters, all inside one 64 byte block picked by the hash, so a lookup touches a
+* single cache line and never allocates. Counters are incremented on insert and decremented on erase so keys can be
+* removed again. A counter that reaches 15 sticks there (it may be shared with keys that were never erased), which can
+* only cause false positives, never false negatives.
+*
+* The filter is sized for a number of keys up front. Going over that capacity still works but the false positive rate
+* goes up, the owner is expected to rebuild it bigger (see BasicAddressBook).
+*/
+class CountingBloomFilter
+{
+public:
+	// Counters per key the filter is sized for, about 2.5% false positives at capacity
+	static constexpr size_t counters_per_key = 8;
+
+	// Number of counters set by every key
+	static constexpr size_t hash_count = 4;
+
+private:
+	// 128 counters of 4 bits, one cache line
+	struct alignas(64) Block
+	{
+		std::array<uint64_t, 8> words;
+	};
+
+	static constexpr size_t counters_per_block = 128;
+	static constexpr uint64_t max_count = 15;
+
+	std::pmr::vector<Block> blocks;
+	size_t key_capacity;
+
+	// Index of the block a hash lands in, from its high 32 bits
+	size_t blockIndex(uint64_t hash) const { return ((hash >> 32) * blocks.size()) >> 32; }
+
+	Block& block(uint64_t hash) { return blocks[blockIndex(hash)]; }
+	const Block& block(uint64_t hash) const { return blocks[blockIndex(hash)]; }
+
+	// Counter i (of hash_count) of a hash within its block, 7 bits of the low 32 bits each
+	static size_t counter(uint64_t hash, size_t i) { return (hash >> (i * 7)) & (counters_per_block - 1); }
+
+	static uint64_t get(const Block& block, size_t counter)
+	{
+		return (block.words[counter / 16] >> (counter % 16 * 4)) & max_count;
+	}
+
+public:
+
+	/*
+	* @brief Construct an empty filter sized for capacity keys
+	*
+	* @param capacity The number of keys to size the filter for
+	* @param resource The memory resource to allocate the counters from
+	*/
+	explicit CountingBloomFilter(size_t capacity = 0, std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+	// Copy constructor, allocating from resource like the std::pmr containers
+	CountingBloomFilter(const CountingBloomFilter& other, std::pmr::memory_resource* resource)
+		: blocks(other.blocks, resource), key_capacity(other.key_capacity) {}
+
+	CountingBloomFilter(const CountingBloomFilter&) = default;
+	CountingBloomFilter(CountingBloomFilter&&) = default;
+	CountingBloomFilter& operator=(const CountingBloomFilter&) = default;
+	CountingBloomFilter& operator=(CountingBloomFilter&&) = default;
+
+
+	/*
+	* @brief Add a key
+	*
+	* @param hash The hash of the key
+	* @return void
+	*/
+	void insert(uint64_t hash);
+
+
+	/*
+	* @brief Remove a key that was inserted
+	*
+	* Erasing a key that was never inserted can cause false negatives for other keys.
+	*
+	* @param hash The hash of the key
+	* @return void
+	*/
+	void erase(uint64_t hash);
+
+
+	/*
+	* @brief Return whether a key may have been inserted
+	*
+	* @param hash The hash of the key
+	* @return bool false if the key is definitely not in the filter
+	*/
+	bool mayContain(uint64_t hash) const
+	{
+		const Block& key_block = block(hash);
+		for (size_t i = 0; i < hash_count; i++) {
+			if (get(key_block, counter(hash, i)) == 0) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+
+	/*
+	* @brief Return which of slice_count slices of the counters a key falls in
+	*
+	* The slices are disjoint runs of blocks, so keys in different slices can be inserted or erased from different
+	* threads at the same time.
+	*
+	* @param hash The hash of the key
+	* @param slice_count The number of slices the counters are split into
+	* @return size_t The slice of the key, from 0 to slice_count - 1
+	*/
+	size_t sliceOf(uint64_t hash, size_t slice_count) const { return blockIndex(hash) * slice_count / blocks.size(); }
+
+
+	/*
+	* @brief Remove every key, keeping the capacity
+	*
+	* @return void
+	*/
+	void clear();
+
+
+	/*
+	* @brief Return the number of keys the filter is sized for
+	*
+	* @return size_t The capacity
+	*/
+	size_t capacity() const { return key_capacity; }
+
+
+	/*
+	* @brief Return the memory taken by the counters
+	*
+	* @return size_t The size of the counters in bytes
+	*/
+	size_t bytes() const { return blocks.size() * sizeof(Block); }
+};
@@ -0,0 +1,156 @@
+#pragma once
+
+#include "address_book.h"
+#include "work_stealing_pool.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+
+/*
+* @brief An address book partitioned across several inner address books (shards)
+*
+* Entries are routed to a shard by hashing their lower case last name, so an entry and any duplicate of it always live
+* in the same shard. Each shard has its own lock, so mutations that land in different shards don't contend with each
+* other. Cross shard queries (find and the sorted listings) run on every shard in parallel, on worker threads owned by
+* the address book, and the per shard results are merged at the end.
+*/
+class ShardedAddressBook
+{
+public:
+	using Entry = AddressBook::Entry;
+
+private:
+	/// A single partition of the address book and the lock that guards it
+	struct Shard
+	{
+		AddressBook book;
+		std::mutex mutex;
+	};
+
+	// The shards, stored behind pointers because std::mutex can't be moved or copied
+	std::vector<std::unique_ptr<Shard>> shards;
+
+	// Runs the per shard queries, declared after the shards so its threads are stopped before the shards go away
+	WorkStealingPool query_pool;
+
+	/*
+	* Method to pick the shard an entry belongs to
+	*
+	* Hashes the lower case last name of the entry. Using the last name (rather than the whole entry) keeps the routing
+	* cheap and still guarantees that two equal entries end up in the same shard.
+	*/
+	Shard& shardFor(const Entry& person);
+
+	/*
+	* Method to run a query on every shard in parallel
+	*
+	* Runs query on each shard (under that shard's lock) on the query pool, the calling thread helping, and returns the
+	* per shard results in shard order. With a single shard the query is run on the calling thread.
+	*/
+	template <typename Query>
+	std::vector<std::vector<Entry>> queryAllShards(Query query);
+
+public:
+
+	/*
+	* @brief Construct an address book with the given number of shards
+	*
+	* Starts a worker thread per shard for the cross shard queries, up to one per core (less the calling thread).
+	*
+	* @param shard_count The number of inner address books to partition entries across
+	* @throws std::invalid_argument if shard_count is 0
+	*/
+	explicit ShardedAddressBook(size_t shard_count);
+
+	// Sharded address books own a lock per shard so they can't be copied
+	ShardedAddressBook(const ShardedAddressBook&) = delete;
+	ShardedAddressBook& operator=(const ShardedAddressBook&) = delete;
+
+
+	/*
+	* @brief Return the number of shards entries are partitioned across
+	*
+	* @return size_t The number of shards
+	*/
+	size_t shardCount() const { return shards.size(); }
+
+
+	/*
+	* @brief Add a person to the address book
+	*
+	* Routes the entry to its shard and adds it there. See AddressBook::add.
+	*
+	* @param person The person to add
+	* @throws std::invalid_argument if the entry does not have a first or last name
+	* @throws std::invalid_argument if the entry already exists
+	* @return void
+	*/
+	void add(const Entry& person);
+
+
+	/*
+	* @brief Remove a person from the address book
+	*
+	* Routes the entry to its shard and removes it there. Only that shard rebuilds its maps. See AddressBook::remove.
+	*
+	* @param person The person to remove
+	* @throws std::invalid_argument if the entry does not exist
+	* @return void
+	*/
+	void remove(const Entry& person);
+
+
+	/*
+	* @brief Add a person to the address book without throwing for routine failures, see AddressBook::tryAdd
+	*
+	* @param person The person to add
+	* @return AddressBook::Status Ok, MissingName, FieldTooLong or AlreadyExists
+	*/
+	[[nodiscard]] AddressBook::Status tryAdd(const Entry& person);
+
+
+	/*
+	* @brief Remove a person from the address book without throwing if it doesn't exist, see AddressBook::tryRemove
+	*
+	* @param person The person to remove
+	* @return AddressBook::Status Ok, FieldTooLong or NotFound
+	*/
+	[[nodiscard]] AddressBook::Status tryRemove(const Entry& person);
+
+
+	/*
+	* @brief Return all entries sorted by first name
+	*
+	* Sorts every shard in parallel and k-way merges the results. Entries with the same first name keep the relative
+	* order of their shards.
+	*
+	* @return std::vector<AddressBook::Entry> The entries sorted by first name
+	*/
+	std::vector<Entry> sortedByFirstName();
+
+
+	/*
+	* @brief Return all entries sorted by last name
+	*
+	* Sorts every shard in parallel and k-way merges the results.
+	*
+	* @return std::vector<AddressBook::Entry> The entries sorted by last name
+	*/
+	std::vector<Entry> sortedByLastName();
+
+
+	/*
+	* @brief Return all entries that match the prefix (case insensitive)
+	*
+	* Runs AddressBook::find on every shard in parallel and k-way merges the results into the same order as
+	* AddressBook::find: entries matching on their first name in first name order, then entries only matching on their
+	* last name in last name order. Entries with the same key keep the relative order of their shards.
+	*
+	* @param prefix The prefix to match
+	* @return std::vector<AddressBook::Entry> The entries that match the prefix
+	*/
+	std::vector<Entry> find(const std::string& prefix);
+
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+* @brief A fixed set of worker threads running jobs from a shared FIFO queue
+*
+* Jobs are plain functions, coroutines can hop onto a worker with co_await queue.schedule(). The threads are started
+* by the constructor and live as long as the queue, so running a job never spawns a thread.
+*/
+class WorkQueue
+{
+	std::mutex mutex;
+	std::condition_variable job_ready;
+	std::deque<std::function<void()>> jobs;
+	bool stopping = false;
+
+	// Declared last so the workers are started after (and stopped before) everything they use
+	std::vector<std::thread> workers;
+
+	/*
+	* Method run by every worker thread
+	*
+	* Runs jobs until the queue is stopping and there are no jobs left
+	*/
+	void run();
+
+public:
+
+	/// Awaitable that resumes the awaiting coroutine on one of the workers
+	class ScheduleAwaiter
+	{
+		WorkQueue& queue;
+
+	public:
+		explicit ScheduleAwaiter(WorkQueue& queue) : queue(queue) {}
+
+		bool await_ready() const noexcept { return false; }
+		void await_suspend(std::coroutine_handle<> handle) { queue.push([handle] { handle.resume(); }); }
+		void await_resume() const noexcept {}
+	};
+
+	/*
+	* @brief Start worker_count worker threads
+	*
+	* @param worker_count The number of worker threads
+	* @throws std::invalid_argument if worker_count is 0
+	*/
+	explicit WorkQueue(size_t worker_count);
+
+	/*
+	* @brief Stop the worker threads
+	*
+	* Jobs already queued are run before the workers exit.
+	*/
+	~WorkQueue();
+
+	// The workers hold a pointer to the queue so it can't be copied or moved
+	WorkQueue(const WorkQueue&) = delete;
+	WorkQueue& operator=(const WorkQueue&) = delete;
+
+
+	/*
+	* @brief Queue a job to be run by the next free worker
+	*
+	* @param job The job to run
+	* @return void
+	*/
+	void push(std::function<void()> job);
+
+
+	/*
+	* @brief Return an awaitable that moves the awaiting coroutine onto a worker
+	*
+	* @return ScheduleAwaiter Awaiting it suspends the coroutine and queues its resumption
+	*/
+	ScheduleAwaiter schedule() { return ScheduleAwaiter(*this); }
+
+
+	/*
+	* @brief Return the number of worker threads
+	*
+	* @return size_t The number of worker threads
+	*/
+	size_t workerCount() const { return workers.size(); }
+};
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+* @brief A thread pool where every worker has its own job deque and idle workers steal from the others
+*
+* Workers take jobs from the back of their own deque and steal from the front of the other deques when theirs is empty,
+* so uneven jobs (e.g. partitions with more entries than others) are balanced without a shared queue everyone contends
+* on. The thread calling parallelFor runs jobs too, so a pool with no threads simply runs everything on the caller and
+* a job can call parallelFor itself without deadlocking.
+*/
+class WorkStealingPool
+{
+	/// The job deque of one worker
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque<std::function<void()>> jobs;
+	};
+
+	// One deque per worker thread
+	std::vector<std::unique_ptr<Queue>> queues;
+
+	// Number of jobs waiting in all the deques, workers sleep while it is 0
+	std::atomic<size_t> queued{ 0 };
+	std::mutex sleep_mutex;
+	std::condition_variable jobs_available;
+	bool stopping = false;
+
+	// Declared last so the threads are started after (and stopped before) everything they use
+	std::vector<std::thread> threads;
+
+	/*
+	* Method to run one queued job, looking in queue first and then stealing from the others
+	*
+	* Returns false if there was no job to run
+	*/
+	bool runOne(size_t queue);
+
+	/*
+	* Method run by every worker thread
+	*/
+	void run(size_t queue);
+
+public:
+
+	/*
+	* @brief Start thread_count worker threads
+	*
+	* @param thread_count The number of worker threads (0 runs every job on the thread calling parallelFor)
+	*/
+	explicit WorkStealingPool(size_t thread_count);
+
+	/*
+	* @brief Stop the worker threads
+	*
+	* Must not be called while a parallelFor is running.
+	*/
+	~WorkStealingPool();
+
+	// The threads refer to the pool so it can't be copied or moved
+	WorkStealingPool(const WorkStealingPool&) = delete;
+	WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+
+	/*
+	* @brief Run body(0) to body(count - 1) on the pool and wait for all of them to finish
+	*
+	* The calls are spread over the worker deques and the calling thread helps run them. If any call throws, the first
+	* exception is rethrown here once every call has finished.
+	*
+	* @param count The number of calls
+	* @param body The function to call with every index
+	* @return void
+	*/
+	void parallelFor(size_t count, const std::function<void(size_t)>& body);
+
+
+	/*
+	* @brief Return the number of worker threads (not counting threads calling parallelFor)
+	*
+	* @return size_t The number of worker threads
+	*/
+	size_t threadCount() const { return threads.size(); }
+
+
+	/*
+	* @brief Return the pool shared by the address book set operations
+	*
+	* Started on first use with one thread less than the hardware has, since the calling thread helps.
+	*
+	* @return WorkStealingPool& The shared pool
+	*/
+	static WorkStealingPool& shared();
+};
@@ -0,0 +1,170 @@
+#include "include/sharded_address_book.h"
+
+#include <stdexcept>
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <queue>
+#include <thread>
+#include <tuple>
+
+
+// Lower case a copy of a name so it can be compared the same way the address book maps compare their keys
+static std::string toLower(const std::string& name)
+{
+	std::string name_lower = name;
+	std::transform(name_lower.begin(), name_lower.end(), name_lower.begin(), ::tolower);
+	return name_lower;
+}
+
+
+/*
+* Merge runs that are each already sorted by key into a single sorted vector
+*
+* A min heap holds the current head of every run. Ties are broken by run index so the merge is stable with respect to
+* the order of the runs.
+*/
+static std::vector<AddressBook::Entry> mergeSortedRuns(std::vector<std::vector<AddressBook::Entry>>& runs,
+	std::string (*key)(const AddressBook::Entry&))
+{
+	// Heap items are (key, run index, position in run)
+	using HeapItem = std::tuple<std::string, size_t, size_t>;
+	std::priority_queue<HeapItem, std::vector<HeapItem>, std::greater<HeapItem>> heap;
+
+	size_t total_size = 0;
+	for (size_t run = 0; run < runs.size(); run++) {
+		total_size += runs[run].size();
+		if (!runs[run].empty()) {
+			heap.emplace(key(runs[run][0]), run, 0);
+		}
+	}
+
+	std::vector<AddressBook::Entry> results;
+	results.reserve(total_size);
+
+	while (!heap.empty()) {
+		auto [item_key, run, position] = heap.top();
+		heap.pop();
+
+		results.push_back(std::move(runs[run][position]));
+
+		// Push the next entry of the same run (if there is one)
+		if (position + 1 < runs[run].size()) {
+			heap.emplace(key(runs[run][position + 1]), run, position + 1);
+		}
+	}
+
+	return results;
+}
+
+
+// Worker threads for a sharded address book: one per shard, up to one per core, less the calling thread which helps
+static size_t queryThreadCount(size_t shard_count)
+{
+	if (shard_count == 0) {
+		throw std::invalid_argument("Shard count must be at least 1");
+	}
+	return std::min<size_t>(shard_count, std::max(1u, std::thread::hardware_concurrency())) - 1;
+}
+
+
+ShardedAddressBook::ShardedAddressBook(size_t shard_count) : query_pool(queryThreadCount(shard_count))
+{
+	shards.reserve(shard_count);
+	for (size_t i = 0; i < shard_count; i++) {
+		shards.push_back(std::make_unique<Shard>());
+	}
+}
+
+
+ShardedAddressBook::Shard& ShardedAddressBook::shardFor(const Entry& person)
+{
+	size_t hash = std::hash<std::string>()(toLower(person.last_name));
+	return *shards[hash % shards.size()];
+}
+
+
+template <typename Query>
+std::vector<std::vector<ShardedAddressBook::Entry>> ShardedAddressBook::queryAllShards(Query query)
+{
+	std::vector<std::vector<Entry>> results(shards.size());
+
+	// The pool runs everything on the calling thread if there is only one shard
+	query_pool.parallelFor(shards.size(), [this, &query, &results](size_t i) {
+		std::lock_guard<std::mutex> lock(shards[i]->mutex);
+		results[i] = query(shards[i]->book);
+	});
+
+	return results;
+}
+
+
+void ShardedAddressBook::add(const Entry& person)
+{
+	Shard& shard = shardFor(person);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	shard.book.add(person);
+}
+
+
+void ShardedAddressBook::remove(const Entry& person)
+{
+	Shard& shard = shardFor(person);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	shard.book.remove(person);
+}
+
+
+AddressBook::Status ShardedAddressBook::tryAdd(const Entry& person)
+{
+	Shard& shard = shardFor(person);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	return shard.book.tryAdd(person);
+}
+
+
+AddressBook::Status ShardedAddressBook::tryRemove(const Entry& person)
+{
+	Shard& shard = shardFor(person);
+	std::lock_guard<std::mutex> lock(shard.mutex);
+	return shard.book.tryRemove(person);
+}
+
+
+std::vector<ShardedAddressBook::Entry> ShardedAddressBook::sortedByFirstName()
+{
+	auto runs = queryAllShards([](AddressBook& book) { return book.sortedByFirstName(); });
+	return mergeSortedRuns(runs, [](const Entry& e) { return toLower(e.first_name); });
+}
+
+
+std::vector<ShardedAddressBook::Entry> ShardedAddressBook::sortedByLastName()
+{
+	auto runs = queryAllShards([](AddressBook& book) { return book.sortedByLastName(); });
+	return mergeSortedRuns(runs, [](const Entry& e) { return toLower(e.last_name); });
+}
+
+
+std::vector<ShardedAddressBook::Entry> ShardedAddressBook::find(const std::string& prefix)
+{
+	auto first_name_runs = queryAllShards([&prefix](AddressBook& book) { return book.find(prefix); });
+
+	// Every shard lists its first name matches in first name order, then the entries that only match on their last
+	// name in last name order. Split the two so each half can be merged across shards on its own key.
+	std::string prefix_lower = toLower(prefix);
+	std::vector<std::vector<Entry>> last_name_runs(first_name_runs.size());
+	for (size_t run = 0; run < first_name_runs.size(); run++) {
+		std::vector<Entry>& matches = first_name_runs[run];
+		auto last_name_only = std::find_if(matches.begin(), matches.end(),
+			[&prefix_lower](const Entry& e) { return !toLower(e.first_name).starts_with(prefix_lower); });
+		std::move(last_name_only, matches.end(), std::back_inserter(last_name_runs[run]));
+		matches.erase(last_name_only, matches.end());
+	}
+
+	// Every entry lives in exactly one shard so no deduplication is needed across shards
+	std::vector<Entry> results = mergeSortedRuns(first_name_runs, [](const Entry& e) { return toLower(e.first_name); });
+	std::vector<Entry> last_name_results = mergeSortedRuns(last_name_runs, [](const Entry& e) { return toLower(e.last_name); });
+	std::move(last_name_results.begin(), last_name_results.end(), std::back_inserter(results));
+
+	return results;
+}
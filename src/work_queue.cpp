@@ -0,0 +1,63 @@
+#include "include/work_queue.h"
+
+#include <stdexcept>
+#include <utility>
+
+
+WorkQueue::WorkQueue(size_t worker_count)
+{
+	if (worker_count == 0) {
+		throw std::invalid_argument("Work queue must have at least one worker");
+	}
+
+	workers.reserve(worker_count);
+	for (size_t i = 0; i < worker_count; i++) {
+		workers.emplace_back([this] { run(); });
+	}
+}
+
+
+WorkQueue::~WorkQueue()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	job_ready.notify_all();
+
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+}
+
+
+void WorkQueue::push(std::function<void()> job)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		jobs.push_back(std::move(job));
+	}
+	job_ready.notify_one();
+}
+
+
+void WorkQueue::run()
+{
+	while (true) {
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			job_ready.wait(lock, [this] { return stopping || !jobs.empty(); });
+
+			// Only exit once everything queued has been run
+			if (jobs.empty()) {
+				return;
+			}
+			job = std::move(jobs.front());
+			jobs.pop_front();
+		}
+
+		// Run the job outside the lock so other workers can pick up jobs meanwhile
+		job();
+	}
+}
@@ -0,0 +1,149 @@
+#include "include/work_stealing_pool.h"
+
+#include <algorithm>
+#include <exception>
+
+
+WorkStealingPool::WorkStealingPool(size_t thread_count)
+{
+	queues.reserve(thread_count);
+	for (size_t i = 0; i < thread_count; i++) {
+		queues.push_back(std::make_unique<Queue>());
+	}
+
+	threads.reserve(thread_count);
+	for (size_t i = 0; i < thread_count; i++) {
+		threads.emplace_back([this, i] { run(i); });
+	}
+}
+
+
+WorkStealingPool::~WorkStealingPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+		stopping = true;
+	}
+	jobs_available.notify_all();
+
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+}
+
+
+WorkStealingPool& WorkStealingPool::shared()
+{
+	static WorkStealingPool pool(std::max(1u, std::thread::hardware_concurrency()) - 1);
+	return pool;
+}
+
+
+bool WorkStealingPool::runOne(size_t queue)
+{
+	std::function<void()> job;
+
+	for (size_t i = 0; i < queues.size() && !job; i++) {
+		Queue& victim = *queues.at((queue + i) % queues.size());
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (victim.jobs.empty()) {
+			continue;
+		}
+
+		// Our own deque is used as a stack (the most recently queued job is the most likely to be in cache), other
+		// deques are stolen from the other end
+		if (i == 0) {
+			job = std::move(victim.jobs.back());
+			victim.jobs.pop_back();
+		}
+		else {
+			job = std::move(victim.jobs.front());
+			victim.jobs.pop_front();
+		}
+	}
+
+	if (!job) {
+		return false;
+	}
+
+	queued--;
+	job();
+	return true;
+}
+
+
+void WorkStealingPool::run(size_t queue)
+{
+	while (true) {
+		if (runOne(queue)) {
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(sleep_mutex);
+		jobs_available.wait(lock, [this] { return stopping || queued > 0; });
+		if (stopping) {
+			return;
+		}
+	}
+}
+
+
+void WorkStealingPool::parallelFor(size_t count, const std::function<void(size_t)>& body)
+{
+	// Nothing to share out, run on the calling thread
+	if (queues.empty() || count <= 1) {
+		for (size_t i = 0; i < count; i++) {
+			body(i);
+		}
+		return;
+	}
+
+	// Completion state shared by the jobs of this call
+	std::atomic<size_t> remaining{ count };
+	std::mutex done_mutex;
+	std::condition_variable done;
+	std::exception_ptr exception;
+
+	// Counted before the jobs are published so a worker taking one never sees queued go below 0
+	{
+		std::lock_guard<std::mutex> lock(sleep_mutex);
+		queued += count;
+	}
+
+	// Deal the calls out over the deques
+	for (size_t i = 0; i < count; i++) {
+		Queue& queue = *queues.at(i % queues.size());
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back([&, i] {
+			try {
+				body(i);
+			}
+			catch (...) {
+				std::lock_guard<std::mutex> lock(done_mutex);
+				if (!exception) {
+					exception = std::current_exception();
+				}
+			}
+
+			// Decremented and notified under the lock, the caller can't return (destroying the completion state)
+			// until this job has let go of it
+			std::lock_guard<std::mutex> lock(done_mutex);
+			if (--remaining == 0) {
+				done.notify_all();
+			}
+		});
+	}
+	jobs_available.notify_all();
+
+	// Help until every job has been taken, then wait for the ones still running elsewhere
+	while (remaining > 0 && runOne(0)) {
+	}
+	{
+		std::unique_lock<std::mutex> lock(done_mutex);
+		done.wait(lock, [&remaining] { return remaining == 0; });
+	}
+
+	if (exception) {
+		std::rethrow_exception(exception);
+	}
+}
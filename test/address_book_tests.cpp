@@ -1,31 +1,14 @@
 #include "address_book.h"
+#include "test_data.h"
 
 #include <gtest/gtest.h>
 #include <string>
-
-///  Sample test data
-std::string people[][3] = {
-		{"Sally", "Graham", "+44 7700 900297"},
-		{"Phoenix", "Bond", "0161 496 0311"},
-		{"Aaran", "Parks", ""},
-		{"Jayden", "Riddle", "+44 131 496 0609"},
-		{"Adriana", "Paul", "(739) 391-4868"},
-		{"Hamza", "Bo", "+44 131 496 0571"}
-	};
-
-///  Sample test data
-AddressBook AddTestPeople()
-{
-	AddressBook addressBook;
-	// Add all of the test data to the address book
-	for (auto person : people)
-	{
-		AddressBook::Entry entry = { person[0], person[1], person[2] };
-		addressBook.add(entry);
-	}
-	return addressBook;
-}
-
+#include <sstream>
+#include <memory_resource>
+#include <algorithm>
+#include <tuple>
+#include <type_traits>
+#include <cstdint>
 
 /// Tests that it is possible to add a person to the address book.
 TEST(AddressBookTests, AddPerson)
@@ -511,6 +494,760 @@ TEST(AddressBookTests, MinusOperatorDoubleSided) {
 	EXPECT_EQ(results.size(), 0);
 }
 
+// Test that the change feed returns the adds and removes made since a version
+TEST(AddressBookTests, ChangesSince) {
+	AddressBook ab = AddTestPeople();
+
+	// One version per entry added
+	ASSERT_EQ(ab.version(), 6);
+	uint64_t synced_version = ab.version();
+
+	// Nothing changed yet
+	EXPECT_EQ(ab.changesSince(synced_version).size(), 0);
+
+	AddressBook::Entry entry = { "Bandit", "Heeler", "832843234" };
+	ab.add(entry);
+	ab.remove({ people[0][0], people[0][1], people[0][2] });
+
+	std::vector<AddressBook::Change> changes = ab.changesSince(synced_version);
+	ASSERT_EQ(changes.size(), 2);
+
+	EXPECT_EQ(changes[0].version, 7);
+	EXPECT_EQ(changes[0].type, AddressBook::ChangeType::Added);
+	EXPECT_EQ(changes[0].entry, entry);
+
+	EXPECT_EQ(changes[1].version, 8);
+	EXPECT_EQ(changes[1].type, AddressBook::ChangeType::Removed);
+	EXPECT_EQ(changes[1].entry.first_name, people[0][0]);
+
+	// Asking for a version from the future is an error
+	EXPECT_THROW(ab.changesSince(ab.version() + 1), std::invalid_argument);
+}
+
+
+// Test that consumers that fall behind the change feed are told to resync
+TEST(AddressBookTests, ChangesSinceLagged) {
+	AddressBook ab(AddressBook::ChangeFeedCapacity{ 3 });
+
+	for (auto person : people) {
+		ab.add({ person[0], person[1], person[2] });
+	}
+
+	// Only the last 3 changes are kept
+	EXPECT_THROW(ab.changesSince(0), std::out_of_range) << "Expected out of range exception for a lagged consumer";
+	EXPECT_THROW(ab.changesSince(2), std::out_of_range) << "Expected out of range exception for a lagged consumer";
+
+	std::vector<AddressBook::Change> changes = ab.changesSince(3);
+	ASSERT_EQ(changes.size(), 3);
+	for (size_t i = 0; i < changes.size(); i++) {
+		EXPECT_EQ(changes[i].version, 4 + i);
+		EXPECT_EQ(changes[i].entry.first_name, people[3 + i][0]);
+	}
+}
+
+// Test that a change feed capacity of 0 disables the change feed but still counts versions
+TEST(AddressBookTests, ChangeFeedDisabled) {
+	AddressBook ab(AddressBook::ChangeFeedCapacity{ 0 });
+
+	for (auto person : people) {
+		ab.add({ person[0], person[1], person[2] });
+	}
+
+	EXPECT_EQ(ab.version(), 6);
+	EXPECT_TRUE(ab.changesSince(ab.version()).empty());
+	EXPECT_THROW(ab.changesSince(ab.version() - 1), std::out_of_range) << "Expected out of range exception without a change feed";
+
+	// Also with a memory resource
+	std::pmr::monotonic_buffer_resource resource;
+	AddressBook ab_resource(AddressBook::ChangeFeedCapacity{ 0 }, &resource);
+	ab_resource.add({ "Ann", "Other", "1" });
+	EXPECT_EQ(ab_resource.memoryResource(), &resource);
+	EXPECT_THROW(ab_resource.changesSince(0), std::out_of_range);
+}
+
+// Test that the find cache answers repeated prefixes and is invalidated by add and remove
+TEST(AddressBookTests, FindCache) {
+	AddressBook ab = AddTestPeople();
+	ab.enableFindCache(8);
+
+	// First search is a miss, the second one is a hit
+	std::vector<AddressBook::Entry> results = ab.find("A");
+	ASSERT_EQ(results.size(), 2);
+	results = ab.find("a");
+	ASSERT_EQ(results.size(), 2);
+
+	AddressBook::FindCacheStats stats = ab.findCacheStats();
+	EXPECT_EQ(stats.hits, 1);
+	EXPECT_EQ(stats.misses, 1);
+	EXPECT_EQ(stats.size, 1);
+
+	// Cache a prefix that adding "Aaliyah" does not affect
+	ab.find("bo");
+
+	// Adding an entry starting with "a" must drop the cached "a" results but keep "bo"
+	ab.add({ "Aaliyah", "Stone", "" });
+	EXPECT_EQ(ab.findCacheStats().size, 1);
+	results = ab.find("a");
+	ASSERT_EQ(results.size(), 3);
+	ab.find("bo");
+	EXPECT_EQ(ab.findCacheStats().hits, 2);
+
+	// Removing the entry must drop the cached "a" results again
+	ab.remove({ "Aaliyah", "Stone", "" });
+	results = ab.find("a");
+	ASSERT_EQ(results.size(), 2);
+
+	// Results must match an uncached search
+	AddressBook uncached = AddTestPeople();
+	EXPECT_EQ(results, uncached.find("a"));
+}
+
+
+// Test that the find cache evicts the least recently used prefix
+TEST(AddressBookTests, FindCacheEviction) {
+	AddressBook ab = AddTestPeople();
+	ab.enableFindCache(2);
+
+	ab.find("a");
+	ab.find("b");
+	ab.find("a");
+	// "b" is the least recently used prefix so it gets evicted
+	ab.find("s");
+	EXPECT_EQ(ab.findCacheStats().size, 2);
+
+	ab.find("a");
+	ab.find("b");
+	AddressBook::FindCacheStats stats = ab.findCacheStats();
+	EXPECT_EQ(stats.hits, 2);
+	EXPECT_EQ(stats.misses, 4);
+
+	// Disabling the cache drops everything
+	ab.disableFindCache();
+	EXPECT_EQ(ab.findCacheStats().size, 0);
+	EXPECT_EQ(ab.find("a").size(), 2);
+}
+
+// Test that the stats report the size gauges and (when compiled in) the operation counters
+TEST(AddressBookTests, Stats) {
+	AddressBook ab = AddTestPeople();
+	ab.add({ "Jacob", "Smith", "000000000" });
+	ab.add({ "Jacob", "Jones", "000000000" });
+	ab.remove({ people[0][0], people[0][1], people[0][2] });
+	ab.find("j");
+
+	AddressBookStats stats = ab.stats();
+	EXPECT_EQ(stats.entries, 7);
+	EXPECT_EQ(stats.first_name_keys, 6);
+	EXPECT_EQ(stats.last_name_keys, 7);
+	EXPECT_EQ(stats.largest_first_name_bucket, 2);
+	EXPECT_EQ(stats.largest_last_name_bucket, 1);
+
+#ifdef ADDRESSBOOK_ENABLE_STATS
+	ASSERT_TRUE(stats.enabled);
+	EXPECT_EQ(stats.operation(AddressBookOperation::Add).calls, 8);
+	EXPECT_EQ(stats.operation(AddressBookOperation::Add).latency.count(), 8);
+	EXPECT_EQ(stats.operation(AddressBookOperation::Remove).calls, 1);
+	EXPECT_EQ(stats.operation(AddressBookOperation::Find).calls, 1);
+	EXPECT_EQ(stats.rebuilds(), 1);
+
+	ab.resetStats();
+	EXPECT_EQ(ab.stats().operation(AddressBookOperation::Add).calls, 0);
+#else
+	EXPECT_FALSE(stats.enabled);
+	EXPECT_EQ(stats.operation(AddressBookOperation::Add).calls, 0);
+	static_assert(std::is_empty_v<OperationRecorder>, "The compiled out recorder should take no space in the book");
+#endif
+
+	// Both dumps include the gauges
+	std::ostringstream text;
+	stats.writeText(text);
+	EXPECT_NE(text.str().find("entries: 7"), std::string::npos);
+
+	std::ostringstream json;
+	stats.writeJson(json);
+	EXPECT_NE(json.str().find("\"entries\":7"), std::string::npos);
+}
+
+
+// Test that latency percentiles land within a sub bucket of the recorded values
+TEST(AddressBookTests, LatencyHistogram) {
+	LatencyHistogram histogram;
+	EXPECT_EQ(histogram.percentile(0.5), 0);
+
+	for (uint64_t ns = 1; ns <= 1000; ns++) {
+		histogram.record(ns);
+	}
+
+	EXPECT_EQ(histogram.count(), 1000);
+	EXPECT_EQ(histogram.min(), 1);
+	EXPECT_EQ(histogram.max(), 1000);
+	EXPECT_DOUBLE_EQ(histogram.mean(), 500.5);
+
+	// Buckets are at most 1/8th wide
+	EXPECT_NEAR(static_cast<double>(histogram.percentile(0.5)), 500.0, 500.0 / 8);
+	EXPECT_NEAR(static_cast<double>(histogram.percentile(0.99)), 990.0, 990.0 / 8);
+	EXPECT_EQ(histogram.percentile(1.0), 960);
+}
+
+// Test that an address book allocates from the memory resource it is given
+TEST(AddressBookTests, MemoryResource) {
+	CountingResource resource;
+	AddressBook ab(&resource);
+	ASSERT_EQ(ab.memoryResource(), &resource);
+
+	for (auto person : people) {
+		ab.add({ person[0], person[1], person[2] });
+	}
+	EXPECT_GT(resource.allocated, 0) << "Expected the entries and maps to be allocated from the memory resource";
+
+	// Everything still works as usual
+	EXPECT_EQ(ab.find("a").size(), 2);
+	ab.remove({ people[0][0], people[0][1], people[0][2] });
+	EXPECT_EQ(ab.sortedByFirstName().size(), 5);
+
+	// Request scoped finds allocate the results (and scratch memory) from the resource they are given
+	CountingResource request_resource;
+	std::pmr::vector<AddressBook::Entry> results = ab.find("a", &request_resource);
+	ASSERT_EQ(results.size(), 2);
+	EXPECT_EQ(results[0].first_name, "Aaran");
+	EXPECT_EQ(results[1].first_name, "Adriana");
+	EXPECT_GT(request_resource.allocated, 0);
+
+	// Copies use the default resource
+	AddressBook copy = ab;
+	EXPECT_EQ(copy.memoryResource(), std::pmr::get_default_resource());
+	EXPECT_EQ(copy.sortedByFirstName(), ab.sortedByFirstName());
+}
+
+/// Whether an address book type can be sorted by first name
+template <typename Book>
+concept SortableByFirstName = requires(Book& book) { book.sortedByFirstName(); };
+
+/// Tests an address book with only a last name index
+TEST(AddressBookTests, LastNameIndexPolicy) {
+	BasicAddressBook<LastNameIndexPolicy> ab;
+	for (auto person : people) {
+		ab.add({ person[0], person[1], person[2] });
+	}
+
+	// Sorting by first name needs the first name index so it doesn't compile for this policy
+	static_assert(!SortableByFirstName<BasicAddressBook<LastNameIndexPolicy>>);
+	static_assert(SortableByFirstName<AddressBook>);
+
+	// find only matches last names
+	std::vector<AddressBook::Entry> results = ab.find("p");
+	ASSERT_EQ(results.size(), 2);
+	EXPECT_EQ(results[0].last_name, "Parks");
+	EXPECT_EQ(results[1].last_name, "Paul");
+	EXPECT_TRUE(ab.find("Sally").empty());
+
+	// Duplicates are still rejected and removes still work
+	EXPECT_THROW(ab.add({ people[0][0], people[0][1], people[0][2] }), std::invalid_argument);
+	ab.remove({ people[2][0], people[2][1], people[2][2] });
+	EXPECT_EQ(ab.sortedByLastName().size(), 5);
+	EXPECT_EQ(ab.find("pa").size(), 1);
+}
+
+
+/// Tests the phone and full text indexes
+TEST(AddressBookTests, FullIndexPolicy) {
+	BasicAddressBook<FullIndexPolicy> ab;
+	for (auto person : people) {
+		ab.add({ person[0], person[1], person[2] });
+	}
+	ab.add({ "Mary Ann", "Lewis-Smith", "+44 131 496 0000" });
+
+	// Phone numbers are matched on their digits only
+	std::vector<AddressBook::Entry> results = ab.findByPhone("+44 131 496 06");
+	ASSERT_EQ(results.size(), 1);
+	EXPECT_EQ(results[0].first_name, "Jayden");
+	EXPECT_EQ(ab.findByPhone("44131").size(), 3);
+	EXPECT_EQ(ab.findByPhone("(739)").size(), 1);
+
+	// Every word of a name is a key, so names can be found by their middle words
+	results = ab.findFullText("ann");
+	ASSERT_EQ(results.size(), 1);
+	EXPECT_EQ(results[0].first_name, "Mary Ann");
+	EXPECT_EQ(ab.findFullText("SMITH").size(), 1);
+
+	// Removing an entry removes it from every index
+	ab.remove({ "Mary Ann", "Lewis-Smith", "+44 131 496 0000" });
+	EXPECT_TRUE(ab.findFullText("ann").empty());
+	EXPECT_EQ(ab.findByPhone("44131").size(), 2);
+
+	// Copies keep the extra indexes
+	BasicAddressBook<FullIndexPolicy> copy = ab;
+	EXPECT_EQ(copy.findByPhone("44131").size(), 2);
+	EXPECT_EQ(copy.findFullText("bo").size(), 2);
+}
+
+
+/// Tests an address book with case sensitive keys
+TEST(AddressBookTests, CaseSensitiveIndexPolicy) {
+	BasicAddressBook<CaseSensitiveIndexPolicy> ab;
+	for (auto person : people) {
+		ab.add({ person[0], person[1], person[2] });
+	}
+
+	EXPECT_EQ(ab.find("A").size(), 2);
+	EXPECT_TRUE(ab.find("a").empty());
+	EXPECT_EQ(ab.find("Bo").size(), 2);
+}
+
+/// Tests case and accent insensitive keys
+TEST(AddressBookTests, AccentInsensitiveIndexPolicy) {
+	BasicAddressBook<AccentInsensitiveIndexPolicy> ab;
+	ab.add({ "Jos\u00e9", "N\u00fa\u00f1ez", "0161 496 0311" });
+	ab.add({ "\u00c6thelred", "\u00d8stergaard", "+44 131 496 0571" });
+	ab.add({ "Jose", "Nunez", "+44 131 496 0609" });
+
+	// Accented and plain spellings find the same entries
+	EXPECT_EQ(ab.find("jose").size(), 2);
+	EXPECT_EQ(ab.find("JOS\u00c9").size(), 2);
+	EXPECT_EQ(ab.find("nu\u00d1").size(), 2);
+	EXPECT_EQ(ab.find("oster").size(), 1);
+
+	// Letters without a plain equivalent are only lower cased
+	EXPECT_EQ(ab.find("\u00e6th").size(), 1);
+	EXPECT_TRUE(ab.find("ath").empty());
+
+	// Entries are still only duplicates if they are exactly equal
+	EXPECT_THROW(ab.add({ "Jose", "Nunez", "+44 131 496 0609" }), std::invalid_argument);
+	ab.remove({ "Jos\u00e9", "N\u00fa\u00f1ez", "0161 496 0311" });
+	ASSERT_EQ(ab.find("jose").size(), 1);
+	EXPECT_EQ(ab.find("jose")[0].first_name, "Jose");
+}
+
+/// A policy that isn't one of the library's: first name and phone indexes, names folded to lower case without hyphens
+struct HyphenInsensitiveIndexPolicy
+{
+	static constexpr bool first_name_index = true;
+	static constexpr bool last_name_index = false;
+	static constexpr bool phone_index = true;
+	static constexpr bool full_text_index = false;
+
+	struct case_folding
+	{
+		static void fold(std::pmr::string& key)
+		{
+			std::erase(key, '-');
+			AsciiCaseFolding::fold(key);
+		}
+	};
+};
+
+/// Tests an address book with a policy defined outside the library
+TEST(AddressBookTests, UserDefinedIndexPolicy) {
+	BasicAddressBook<HyphenInsensitiveIndexPolicy> ab;
+	ab.add({ "Mary-Jane", "Watson", "0161 496 0311" });
+	ab.add({ "Maryanne", "Hill", "+44 131 496 0571" });
+	ab.add({ "Jean-Luc", "Picard", "(739) 391-4868" });
+
+	// find only matches first names, ignoring hyphens
+	EXPECT_EQ(ab.find("maryj").size(), 1);
+	EXPECT_EQ(ab.find("MARY").size(), 2);
+	EXPECT_EQ(ab.find("jeanl")[0].last_name, "Picard");
+	EXPECT_TRUE(ab.find("watson").empty());
+
+	EXPECT_EQ(ab.findByPhone("739391").size(), 1);
+
+	// Transactions and set operations work as with the built in policies
+	auto transaction = ab.begin();
+	transaction.remove({ "Maryanne", "Hill", "+44 131 496 0571" });
+	transaction.add({ "Mary", "Poppins", "" });
+	transaction.commit();
+	std::vector<AddressBook::Entry> sorted = ab.sortedByFirstName();
+	ASSERT_EQ(sorted.size(), 3);
+	EXPECT_EQ(sorted[0].first_name, "Jean-Luc");
+	EXPECT_EQ(sorted[1].first_name, "Mary");
+	EXPECT_EQ(sorted[2].first_name, "Mary-Jane");
+	EXPECT_EQ((ab - ab).sortedByFirstName().size(), 0);
+}
+
+/// Tests that a transaction applies a mixed batch like the individual calls would
+TEST(AddressBookTests, TransactionCommit) {
+	AddressBook ab = AddTestPeople();
+	AddressBook expected = AddTestPeople();
+	uint64_t version = ab.version();
+
+	auto transaction = ab.begin();
+	transaction.remove({ people[0][0], people[0][1], people[0][2] });
+	transaction.add({ "Aaron", "Parker", "01" });
+	transaction.remove({ people[3][0], people[3][1], people[3][2] });
+	transaction.add({ "Hamza", "Bo", "02" });
+	EXPECT_EQ(transaction.size(), 4);
+
+	// Nothing happens until commit
+	EXPECT_EQ(ab.version(), version);
+	EXPECT_EQ(ab.find("aaro").size(), 0);
+
+	transaction.commit();
+	EXPECT_EQ(transaction.size(), 0);
+
+	expected.remove({ people[0][0], people[0][1], people[0][2] });
+	expected.add({ "Aaron", "Parker", "01" });
+	expected.remove({ people[3][0], people[3][1], people[3][2] });
+	expected.add({ "Hamza", "Bo", "02" });
+
+	EXPECT_EQ(ab.sortedByFirstName(), expected.sortedByFirstName());
+	EXPECT_EQ(ab.sortedByLastName(), expected.sortedByLastName());
+	EXPECT_EQ(ab.find("a"), expected.find("a"));
+	EXPECT_EQ(ab.find("bo").size(), 3);
+	EXPECT_EQ(ab.find("r").size(), 0);
+
+	// The change feed has every net change
+	std::vector<AddressBook::Change> changes = ab.changesSince(version);
+	ASSERT_EQ(changes.size(), 4);
+	EXPECT_EQ(changes[0].type, AddressBook::ChangeType::Removed);
+	EXPECT_EQ(changes[2].type, AddressBook::ChangeType::Added);
+	EXPECT_EQ(ab.version(), version + 4);
+
+	// Adding and removing the same new entry in one batch changes nothing, removing and adding an entry back is fine
+	transaction.add({ "Temp", "Orary", "" });
+	transaction.remove({ "Temp", "Orary", "" });
+	transaction.remove({ "Aaron", "Parker", "01" });
+	transaction.add({ "Aaron", "Parker", "01" });
+	transaction.commit();
+	EXPECT_EQ(ab.version(), version + 4);
+	EXPECT_EQ(ab.sortedByFirstName(), expected.sortedByFirstName());
+}
+
+
+/// Tests that an invalid batch is rejected as a whole
+TEST(AddressBookTests, TransactionRollback) {
+	AddressBook ab = AddTestPeople();
+	std::vector<AddressBook::Entry> before = ab.sortedByFirstName();
+	uint64_t version = ab.version();
+
+	// Duplicate within the batch
+	auto transaction = ab.begin();
+	transaction.remove({ people[1][0], people[1][1], people[1][2] });
+	transaction.add({ "Aaron", "Parker", "01" });
+	transaction.add({ "Aaron", "Parker", "01" });
+	EXPECT_THROW(transaction.commit(), std::invalid_argument);
+	EXPECT_EQ(transaction.size(), 0);
+
+	// Duplicate of an existing entry, removing an entry that doesn't exist, removing twice, entry without a name
+	transaction.add({ people[2][0], people[2][1], people[2][2] });
+	EXPECT_THROW(transaction.commit(), std::invalid_argument);
+	transaction.remove({ "Aaron", "Parker", "01" });
+	EXPECT_THROW(transaction.commit(), std::invalid_argument);
+	transaction.remove({ people[2][0], people[2][1], people[2][2] });
+	transaction.remove({ people[2][0], people[2][1], people[2][2] });
+	EXPECT_THROW(transaction.commit(), std::invalid_argument);
+	transaction.add({ "", "", "0" });
+	EXPECT_THROW(transaction.commit(), std::invalid_argument);
+
+	EXPECT_EQ(ab.sortedByFirstName(), before);
+	EXPECT_EQ(ab.version(), version);
+
+	// rollback drops the queued mutations
+	transaction.add({ "Aaron", "Parker", "01" });
+	transaction.rollback();
+	transaction.commit();
+	EXPECT_EQ(ab.sortedByFirstName(), before);
+}
+
+
+/// Tests that a transaction keeps the phone and full text indexes up to date
+TEST(AddressBookTests, TransactionFullIndexPolicy) {
+	BasicAddressBook<FullIndexPolicy> ab;
+	auto transaction = ab.begin();
+	for (auto person : people) {
+		transaction.add({ person[0], person[1], person[2] });
+	}
+	transaction.add({ "Mary Ann", "Lewis-Smith", "+44 131 496 0000" });
+	transaction.commit();
+
+	EXPECT_EQ(ab.findByPhone("44131").size(), 3);
+	EXPECT_EQ(ab.findFullText("ann").size(), 1);
+	EXPECT_EQ(ab.find("b").size(), 2);
+
+	transaction.remove({ "Mary Ann", "Lewis-Smith", "+44 131 496 0000" });
+	transaction.remove({ people[5][0], people[5][1], people[5][2] });
+	transaction.commit();
+
+	EXPECT_EQ(ab.findByPhone("44131").size(), 1);
+	EXPECT_TRUE(ab.findFullText("ann").empty());
+	EXPECT_EQ(ab.sortedByLastName().size(), 5);
+	EXPECT_EQ(ab.stats().first_name_keys, 5);
+}
+
+/// Tests a larger batch against the same mutations made one at a time
+TEST(AddressBookTests, TransactionLargeBatch) {
+	AddressBook ab;
+	AddressBook expected;
+	for (size_t i = 0; i < 100; i++) {
+		ab.add(numberedEntry(i, 7, 13));
+		expected.add(numberedEntry(i, 7, 13));
+	}
+
+	auto transaction = ab.begin();
+	for (size_t i = 0; i < 150; i++) {
+		if (i < 100 && i % 3 == 0) {
+			transaction.remove(numberedEntry(i, 7, 13));
+			expected.remove(numberedEntry(i, 7, 13));
+		}
+		else if (i >= 100) {
+			transaction.add(numberedEntry(i, 7, 13));
+			expected.add(numberedEntry(i, 7, 13));
+		}
+	}
+	transaction.commit();
+
+	// remove moves the last entry into the hole, the batch keeps the order of the remaining entries, so entries with
+	// the same name can be listed in a different order
+	auto sorted = [](std::vector<AddressBook::Entry> entries) {
+		std::sort(entries.begin(), entries.end(), [](const AddressBook::Entry& lhs, const AddressBook::Entry& rhs) {
+			return std::tie(lhs.first_name, lhs.last_name, lhs.phone_number)
+				< std::tie(rhs.first_name, rhs.last_name, rhs.phone_number);
+		});
+		return entries;
+	};
+	EXPECT_EQ(sorted(ab.sortedByFirstName()), sorted(expected.sortedByFirstName()));
+	EXPECT_EQ(sorted(ab.sortedByLastName()), sorted(expected.sortedByLastName()));
+	std::vector<AddressBook::Entry> by_last_name = ab.sortedByLastName();
+	EXPECT_TRUE(std::is_sorted(by_last_name.begin(), by_last_name.end(),
+		[](const AddressBook::Entry& lhs, const AddressBook::Entry& rhs) { return lhs.last_name < rhs.last_name; }));
+	EXPECT_EQ(ab.find("first3").size(), expected.find("first3").size());
+	EXPECT_EQ(ab.find("last1").size(), expected.find("last1").size());
+	EXPECT_EQ(ab.stats().last_name_keys, 13);
+}
+
+
+/// Tests that operator& keeps the entries that are in both address books
+TEST(AddressBookTests, IntersectionOperator) {
+	AddressBook ab = AddTestPeople();
+
+	AddressBook ab_other;
+	ab_other.add({ "Adriana", "Paul", "(739) 391-4868" });
+	ab_other.add({ "Jayden", "Riddle", "+44 131 496 0609" });
+	ab_other.add({ "Non", "Existant", "000000000" });
+
+	AddressBook result = ab & ab_other;
+	std::vector<AddressBook::Entry> expected = {
+		{ "Adriana", "Paul", "(739) 391-4868" },
+		{ "Jayden", "Riddle", "+44 131 496 0609" }
+	};
+	EXPECT_EQ(result.sortedByFirstName(), expected);
+	EXPECT_EQ(result.find("j").size(), 1);
+
+	// The entries dropped are recorded as removals, both operands are left alone
+	EXPECT_EQ(result.version(), ab.version() + 4);
+	EXPECT_EQ(ab.sortedByFirstName().size(), 6);
+	EXPECT_EQ(ab_other.sortedByFirstName().size(), 3);
+
+	EXPECT_TRUE((ab & AddressBook()).sortedByFirstName().empty());
+}
+
+
+/// Tests that the set operations give the same results whether they are split over a pool or not
+TEST(AddressBookTests, SetOperationsOnPool) {
+	using FullAddressBook = BasicAddressBook<FullIndexPolicy>;
+
+	// Large enough to be split into partitions, with a third of the entries in both books
+	FullAddressBook lhs;
+	FullAddressBook rhs;
+	for (size_t i = 0; i < 6000; i++) {
+		lhs.add(numberedEntry(i, 101, 97));
+	}
+	for (size_t i = 4000; i < 9000; i++) {
+		rhs.add(numberedEntry(i, 101, 97));
+	}
+
+	// An entry too long to fit inline, in both books
+	AddressBook::Entry spilled = { std::string(80, 'F'), "Spilled", "1" };
+	lhs.add(spilled);
+	rhs.add(spilled);
+
+	WorkStealingPool sequential(0);
+	WorkStealingPool pool(3);
+	auto expectSame = [](FullAddressBook& actual, FullAddressBook& expected) {
+		EXPECT_EQ(actual.sortedByFirstName(), expected.sortedByFirstName());
+		EXPECT_EQ(actual.sortedByLastName(), expected.sortedByLastName());
+		EXPECT_EQ(actual.findByPhone("12"), expected.findByPhone("12"));
+		EXPECT_EQ(actual.findFullText("9"), expected.findFullText("9"));
+		EXPECT_EQ(actual.stats().full_text_keys, expected.stats().full_text_keys);
+		EXPECT_EQ(actual.version(), expected.version());
+		std::vector<FullAddressBook::Change> actual_changes = actual.changesSince(actual.version() - 10);
+		std::vector<FullAddressBook::Change> expected_changes = expected.changesSince(expected.version() - 10);
+		ASSERT_EQ(actual_changes.size(), expected_changes.size());
+		for (size_t i = 0; i < actual_changes.size(); i++) {
+			EXPECT_EQ(actual_changes[i].type, expected_changes[i].type);
+			EXPECT_EQ(actual_changes[i].entry, expected_changes[i].entry);
+		}
+
+		// The rebuilt filters hold every entry
+		for (const AddressBook::Entry& entry : expected.sortedByFirstName()) {
+			EXPECT_EQ(actual.tryAdd(entry), FullAddressBook::Status::AlreadyExists);
+		}
+	};
+
+	FullAddressBook united = lhs.unionWith(rhs, pool);
+	FullAddressBook united_expected = lhs.unionWith(rhs, sequential);
+	EXPECT_EQ(united.stats().entries, 9001);
+	expectSame(united, united_expected);
+
+	FullAddressBook difference = lhs.differenceWith(rhs, pool);
+	FullAddressBook difference_expected = lhs.differenceWith(rhs, sequential);
+	EXPECT_EQ(difference.stats().entries, 4000);
+	EXPECT_TRUE(difference.findByPhone("4000").empty());
+	expectSame(difference, difference_expected);
+
+	FullAddressBook intersection = lhs.intersectionWith(rhs, pool);
+	FullAddressBook intersection_expected = lhs.intersectionWith(rhs, sequential);
+	EXPECT_EQ(intersection.stats().entries, 2001);
+	EXPECT_EQ(intersection.findByPhone("5999").size(), 1);
+	expectSame(intersection, intersection_expected);
+
+	// The results allocate from the default resource, which is only filled from several threads if it is the global heap
+	CountingResource resource;
+	std::pmr::memory_resource* default_resource = std::pmr::set_default_resource(&resource);
+	FullAddressBook united_on_resource = lhs.unionWith(rhs, pool);
+	std::pmr::set_default_resource(default_resource);
+	EXPECT_EQ(united_on_resource.memoryResource(), &resource);
+	expectSame(united_on_resource, united_expected);
+
+	// Only the newest changes are kept in the change feed of the result
+	std::vector<FullAddressBook::Change> changes = united.changesSince(united.version() - 2);
+	ASSERT_EQ(changes.size(), 2);
+	EXPECT_EQ(changes.back().type, FullAddressBook::ChangeType::Added);
+	EXPECT_EQ(changes.back().entry, numberedEntry(8999, 101, 97));
+}
+
+
+/// Tests finding entries by their whole first or last name
+TEST(AddressBookTests, FindExact) {
+	AddressBook ab = AddTestPeople();
+	ab.add({ "Graham", "Graham", "1" });
+
+	std::vector<AddressBook::Entry> results = ab.findExact("graham");
+	ASSERT_EQ(results.size(), 2);
+	EXPECT_EQ(results.at(0), AddressBook::Entry({ "Graham", "Graham", "1" }));
+	EXPECT_EQ(results.at(1), AddressBook::Entry({ "Sally", "Graham", "+44 7700 900297" }));
+
+	// Whole names only
+	EXPECT_TRUE(ab.findExact("Grah").empty());
+	EXPECT_TRUE(ab.findExact("Nobody").empty());
+
+	ab.remove({ "Graham", "Graham", "1" });
+	EXPECT_EQ(ab.findExact("GRAHAM").size(), 1);
+
+	BasicAddressBook<LastNameIndexPolicy> by_last_name;
+	by_last_name.add({ "Sally", "Graham", "" });
+	EXPECT_EQ(by_last_name.findExact("graham").size(), 1);
+	EXPECT_TRUE(by_last_name.findExact("sally").empty());
+}
+
+
+/// Tests that the Bloom filters keep up as the address book grows past their capacity and shrinks again
+TEST(AddressBookTests, BloomFilterGrowth) {
+	AddressBook ab;
+
+	for (size_t i = 0; i < 3000; i++) {
+		ab.add(numberedEntry(i, SIZE_MAX, 50));
+	}
+	for (size_t i = 0; i < 3000; i++) {
+		EXPECT_THROW(ab.add(numberedEntry(i, SIZE_MAX, 50)), std::invalid_argument);
+	}
+	EXPECT_EQ(ab.findExact("first2999").size(), 1);
+
+	// Removed entries can be added again, entries that were never there can't be removed
+	for (size_t i = 0; i < 3000; i += 3) {
+		ab.remove(numberedEntry(i, SIZE_MAX, 50));
+	}
+	EXPECT_THROW(ab.remove(numberedEntry(0, SIZE_MAX, 50)), std::invalid_argument);
+	EXPECT_THROW(ab.remove(numberedEntry(5000, SIZE_MAX, 50)), std::invalid_argument);
+	EXPECT_TRUE(ab.findExact("first3").empty());
+	ab.add(numberedEntry(0, SIZE_MAX, 50));
+	EXPECT_EQ(ab.findExact("first0").size(), 1);
+
+	// The set operations and transactions keep the filters of their results in step too
+	AddressBook others;
+	others.add(numberedEntry(3, SIZE_MAX, 50));
+	others.add(numberedEntry(4, SIZE_MAX, 50));
+	AddressBook united = ab + others;
+	EXPECT_THROW(united.add(numberedEntry(3, SIZE_MAX, 50)), std::invalid_argument);
+	AddressBook difference = ab - others;
+	EXPECT_THROW(difference.remove(numberedEntry(4, SIZE_MAX, 50)), std::invalid_argument);
+	EXPECT_NO_THROW(difference.add(numberedEntry(4, SIZE_MAX, 50)));
+
+	auto transaction = ab.begin();
+	transaction.remove(numberedEntry(1, SIZE_MAX, 50));
+	transaction.add(numberedEntry(3, SIZE_MAX, 50));
+	transaction.commit();
+	EXPECT_THROW(ab.remove(numberedEntry(1, SIZE_MAX, 50)), std::invalid_argument);
+	EXPECT_THROW(ab.add(numberedEntry(3, SIZE_MAX, 50)), std::invalid_argument);
+	EXPECT_EQ(ab.findExact("first3").size(), 1);
+}
+
+
+/// Tests that turning away a missing or duplicate entry doesn't allocate from the address book's resource
+TEST(AddressBookTests, RejectionsDontAllocate) {
+	CountingResource resource;
+	AddressBook ab(&resource);
+	for (auto person : people) {
+		ab.add({ person[0], person[1], person[2] });
+	}
+	ab.add({ "Bartholomew-Maximilian", "Fitzgerald-Montgomery", "+44 131 496 0000" });
+
+	size_t allocated = resource.allocated;
+	EXPECT_EQ(ab.tryRemove({ "Bartholomew-Maximilian", "Fitzgerald-Montgomery", "+44 131 496 0001" }),
+		AddressBook::Status::NotFound);
+	EXPECT_EQ(ab.tryRemove({ "Nobody", "Anybody", "0" }), AddressBook::Status::NotFound);
+	EXPECT_EQ(ab.tryAdd({ "Bartholomew-Maximilian", "Fitzgerald-Montgomery", "+44 131 496 0000" }),
+		AddressBook::Status::AlreadyExists);
+	EXPECT_EQ(ab.tryAdd({ people[1][0], people[1][1], people[1][2] }), AddressBook::Status::AlreadyExists);
+	EXPECT_EQ(resource.allocated, allocated);
+}
+
+/// Tests that tryAdd, tryRemove and tryCommit report failures in their result and leave the address book alone
+TEST(AddressBookTests, TryAddTryRemove) {
+	AddressBook ab = AddTestPeople();
+	uint64_t version = ab.version();
+
+	AddressBook::Entry existing = { "Sally", "Graham", "+44 7700 900297" };
+	AddressBook::Entry new_entry = { "Non", "Existant", "000000000" };
+
+	EXPECT_EQ(ab.tryAdd(existing), AddressBook::Status::AlreadyExists);
+	EXPECT_EQ(ab.tryAdd({ "", "", "123" }), AddressBook::Status::MissingName);
+	EXPECT_EQ(ab.tryRemove(new_entry), AddressBook::Status::NotFound);
+
+	// Fields that are too long to store are reported too, add and remove throw std::length_error for them
+	AddressBook::Entry too_long = { std::string(CompactEntry::max_field_length + 1, 'a'), "Bo", "" };
+	EXPECT_EQ(ab.tryAdd(too_long), AddressBook::Status::FieldTooLong);
+	EXPECT_EQ(ab.tryRemove(too_long), AddressBook::Status::FieldTooLong);
+	EXPECT_THROW(ab.add(too_long), std::length_error);
+	EXPECT_EQ(ab.version(), version);
+	EXPECT_EQ(ab.sortedByFirstName().size(), 6);
+
+	EXPECT_EQ(ab.tryAdd(new_entry), AddressBook::Status::Ok);
+	EXPECT_EQ(ab.find("non").size(), 1);
+	EXPECT_EQ(ab.tryRemove(new_entry), AddressBook::Status::Ok);
+	EXPECT_TRUE(ab.find("non").empty());
+	EXPECT_EQ(ab.version(), version + 2);
+
+	// The first invalid mutation of a batch is reported and nothing is applied
+	auto transaction = ab.begin();
+	transaction.add(new_entry);
+	transaction.remove(existing);
+	transaction.remove(existing);
+	EXPECT_EQ(transaction.tryCommit(), AddressBook::Status::NotFound);
+	EXPECT_EQ(transaction.size(), 0);
+	EXPECT_TRUE(ab.find("non").empty());
+	EXPECT_EQ(ab.find("sally").size(), 1);
+
+	transaction.add(new_entry);
+	transaction.add(too_long);
+	EXPECT_EQ(transaction.tryCommit(), AddressBook::Status::FieldTooLong);
+
+	transaction.add(new_entry);
+	transaction.remove(existing);
+	EXPECT_EQ(transaction.tryCommit(), AddressBook::Status::Ok);
+	EXPECT_EQ(ab.find("non").size(), 1);
+	EXPECT_TRUE(ab.find("sally").empty());
+}
+
 int main(int argc, char** argv)
 {
 	::testing::InitGoogleTest(&argc, argv);
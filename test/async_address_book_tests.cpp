@@ -0,0 +1,122 @@
+#include "async_address_book.h"
+#include "test_data.h"
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/// Drains a listing into the chunks it yields
+static Task<std::vector<std::vector<AddressBook::Entry>>> collectChunks(AsyncGenerator<std::vector<AddressBook::Entry>> listing)
+{
+	std::vector<std::vector<AddressBook::Entry>> chunks;
+	while (std::optional<std::vector<AddressBook::Entry>> chunk = co_await listing.next()) {
+		chunks.push_back(std::move(*chunk));
+	}
+	co_return chunks;
+}
+
+
+/// Tests that findAsync gives the same results as find
+TEST(AsyncAddressBookTests, FindAsync)
+{
+	AddressBook ab = AddTestPeople();
+	AsyncAddressBook async_book(ab, 2);
+
+	std::vector<AddressBook::Entry> results = syncWait(async_book.findAsync("a"));
+	EXPECT_EQ(results, ab.find("a"));
+	EXPECT_EQ(results.size(), 2);
+
+	EXPECT_TRUE(syncWait(async_book.findAsync("zz")).empty());
+}
+
+
+/// Tests that sorted listings are delivered in order, in chunks of at most chunk_size entries
+TEST(AsyncAddressBookTests, SortedListingsInChunks)
+{
+	AddressBook ab = AddTestPeople();
+	AsyncAddressBook async_book(ab);
+
+	std::vector<std::vector<AddressBook::Entry>> chunks = syncWait(collectChunks(async_book.sortedByFirstNameAsync(4)));
+	ASSERT_EQ(chunks.size(), 2);
+	EXPECT_EQ(chunks[0].size(), 4);
+	EXPECT_EQ(chunks[1].size(), 2);
+
+	std::vector<AddressBook::Entry> listed;
+	for (auto& chunk : chunks) {
+		listed.insert(listed.end(), chunk.begin(), chunk.end());
+	}
+	EXPECT_EQ(listed, ab.sortedByFirstName());
+
+	// A chunk can end part way through the entries sharing a name
+	ab.add({ "Hamza", "Bond", "1" });
+	ab.add({ "Hamza", "Parks", "2" });
+	chunks = syncWait(collectChunks(async_book.sortedByLastNameAsync(1)));
+	EXPECT_EQ(chunks.size(), 8);
+	listed.clear();
+	for (auto& chunk : chunks) {
+		listed.insert(listed.end(), chunk.begin(), chunk.end());
+	}
+	EXPECT_EQ(listed, ab.sortedByLastName());
+
+	EXPECT_THROW(async_book.sortedByFirstNameAsync(0), std::invalid_argument);
+	EXPECT_THROW(WorkQueue(0), std::invalid_argument);
+}
+
+
+/// Tests that the listing carries on from where it got to when the book changes between chunks
+TEST(AsyncAddressBookTests, ChangesBetweenChunks)
+{
+	AddressBook ab = AddTestPeople();
+	AsyncAddressBook async_book(ab);
+
+	auto listing = [](AsyncAddressBook& async_book) -> Task<std::vector<std::string>> {
+		std::vector<std::string> first_names;
+		AsyncGenerator<std::vector<AddressBook::Entry>> chunks = async_book.sortedByFirstNameAsync(2);
+
+		// aaran, adriana
+		std::optional<std::vector<AddressBook::Entry>> chunk = co_await chunks.next();
+		for (auto& entry : *chunk) {
+			first_names.push_back(entry.first_name);
+		}
+
+		// Remove a name that was already listed and one that hasn't been yet
+		async_book.remove({ "Aaran", "Parks", "" });
+		async_book.remove({ "Jayden", "Riddle", "+44 131 496 0609" });
+
+		while ((chunk = co_await chunks.next())) {
+			for (auto& entry : *chunk) {
+				first_names.push_back(entry.first_name);
+			}
+		}
+		co_return first_names;
+	};
+
+	std::vector<std::string> expected = { "Aaran", "Adriana", "Hamza", "Phoenix", "Sally" };
+	EXPECT_EQ(syncWait(listing(async_book)), expected);
+}
+
+
+/// Tests that many queries can be in flight at once without a thread per query
+TEST(AsyncAddressBookTests, ConcurrentQueries)
+{
+	AddressBook ab = AddTestPeople();
+	AsyncAddressBook async_book(ab, 4);
+
+	std::vector<std::thread> callers;
+	std::atomic<size_t> matches{ 0 };
+	for (size_t i = 0; i < 8; i++) {
+		callers.emplace_back([&] {
+			for (size_t j = 0; j < 50; j++) {
+				matches += syncWait(async_book.findAsync("p")).size();
+			}
+		});
+	}
+	for (std::thread& caller : callers) {
+		caller.join();
+	}
+
+	// Phoenix Bond, Aaran Parks and Adriana Paul
+	EXPECT_EQ(matches, 8 * 50 * 3);
+}
@@ -0,0 +1,130 @@
+#include "autocomplete_session.h"
+#include "test_data.h"
+
+#include <gtest/gtest.h>
+#include <string>
+
+/// Tests that typing narrows the suggestions and backspace widens them again
+TEST(AutocompleteSessionTests, TypeAndBackspace)
+{
+	AddressBook ab = AddAutocompletePeople();
+	AutocompleteSession session(ab, 10);
+
+	// Empty prefix matches everything
+	EXPECT_EQ(session.suggestions().size(), 5);
+
+	session.type("J");
+	EXPECT_EQ(session.prefix(), "j");
+	std::vector<AddressBook::Entry> results = session.suggestions();
+
+	// Ranked by the matching name: jacob, james, jarvis, jayden, jayne (James Jayne is only returned once)
+	ASSERT_EQ(results.size(), 4);
+	EXPECT_EQ(results[0].first_name, "Jacob");
+	EXPECT_EQ(results[1].first_name, "James");
+	EXPECT_EQ(results[2].first_name, "Sally");
+	EXPECT_EQ(results[3].first_name, "Jayden");
+
+	session.type("ay");
+	results = session.suggestions();
+	ASSERT_EQ(results.size(), 2);
+	EXPECT_EQ(results[0].first_name, "Jayden");
+	EXPECT_EQ(results[1].first_name, "James");
+
+	session.type("dx");
+	EXPECT_EQ(session.suggestions().size(), 0);
+
+	session.backspace();
+	session.backspace();
+	EXPECT_EQ(session.prefix(), "jay");
+	EXPECT_EQ(session.suggestions().size(), 2);
+
+	session.backspace();
+	session.backspace();
+	session.backspace();
+	session.backspace();
+	EXPECT_EQ(session.prefix(), "");
+	EXPECT_EQ(session.suggestions().size(), 5);
+}
+
+
+/// Tests that only the top suggestions are returned
+TEST(AutocompleteSessionTests, MaxSuggestions)
+{
+	AddressBook ab = AddAutocompletePeople();
+	AutocompleteSession session(ab, 2);
+
+	session.type("j");
+	std::vector<AddressBook::Entry> results = session.suggestions();
+	ASSERT_EQ(results.size(), 2);
+	EXPECT_EQ(results[0].first_name, "Jacob");
+	EXPECT_EQ(results[1].first_name, "James");
+}
+
+
+/// Tests that the session picks up changes made to the address book
+TEST(AutocompleteSessionTests, BookChanges)
+{
+	AddressBook ab = AddAutocompletePeople();
+	AutocompleteSession session(ab, 10);
+
+	session.type("ja");
+	EXPECT_EQ(session.suggestions().size(), 4);
+
+	ab.add({ "Jade", "Wu", "" });
+	EXPECT_EQ(session.suggestions().size(), 5);
+
+	// remove rebuilds the maps which would leave the session with dangling iterators if it didn't notice
+	ab.remove({ "Jacob", "Smith", "000000000" });
+	ab.remove({ "Jade", "Wu", "" });
+	session.type("c");
+	EXPECT_EQ(session.suggestions().size(), 0);
+	session.backspace();
+	EXPECT_EQ(session.suggestions().size(), 3);
+}
+
+
+/// Tests that the session picks up the maps being rebuilt or replaced without the version changing
+TEST(AutocompleteSessionTests, MapsRebuilt)
+{
+	AddressBook ab = AddAutocompletePeople();
+	AutocompleteSession session(ab, 10);
+
+	session.type("ja");
+	EXPECT_EQ(session.suggestions().size(), 4);
+
+	// Subtracting an empty book removes nothing but replaces every map
+	ab = ab - AddressBook();
+	EXPECT_EQ(session.suggestions().size(), 4);
+
+	AddressBook other = AddAutocompletePeople();
+	other.remove({ "Sally", "Jarvis", "+44 7700 900297" });
+	ab = other;
+	EXPECT_EQ(session.suggestions().size(), 3);
+}
+
+
+/// Tests that narrowing gives the same matches as find, both when the bounds are walked in and when they are looked up
+TEST(AutocompleteSessionTests, MatchesFind)
+{
+	// Enough names that narrowing the first characters gives up walking and looks the bounds up in the maps
+	AddressBook ab;
+	const std::string letters = "abcdefgh";
+	for (char a : letters) {
+		for (char b : letters) {
+			for (char c : letters) {
+				ab.add({ std::string{ 'F', a, b, c }, std::string{ 'l', c, b, a }, "" });
+			}
+		}
+	}
+	AutocompleteSession session(ab, 512);
+
+	for (const std::string& prefix : { "fab", "fhhh", "lca", "lx", "f\xc3\x89" }) {
+		for (char c : prefix) {
+			session.type(std::string(1, c));
+			EXPECT_EQ(session.suggestions().size(), ab.find(session.prefix()).size()) << session.prefix();
+		}
+		while (!session.prefix().empty()) {
+			session.backspace();
+		}
+	}
+}
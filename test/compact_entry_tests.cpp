@@ -0,0 +1,114 @@
+#include "compact_entry.h"
+#include "address_book.h"
+#include "test_data.h"
+
+#include <gtest/gtest.h>
+#include <memory_resource>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+/// Tests that a short entry is packed inline and unpacks to the same entry
+TEST(CompactEntryTests, RoundTrip)
+{
+	AddressBook::Entry entry = { "Sally", "Graham", "+44 7700 900297" };
+	CompactEntry compact(entry, "sally", "graham");
+
+	EXPECT_EQ(compact.firstName(), "Sally");
+	EXPECT_EQ(compact.lastName(), "Graham");
+	EXPECT_EQ(compact.phoneNumber(), "+44 7700 900297");
+	EXPECT_EQ(compact.firstNameFolded(), "sally");
+	EXPECT_EQ(compact.lastNameFolded(), "graham");
+	EXPECT_EQ(compact.toEntry(), entry);
+}
+
+
+/// Tests entries that are too long to fit inline
+TEST(CompactEntryTests, Spilled)
+{
+	std::string first_name(100, 'A');
+	std::string last_name(200, 'B');
+	AddressBook::Entry entry = { first_name, last_name, "0161 496 0311" };
+	CompactEntry compact(entry, std::string(100, 'a'), std::string(200, 'b'));
+	EXPECT_EQ(compact.toEntry(), entry);
+	EXPECT_EQ(compact.lastNameFolded(), std::string(200, 'b'));
+
+	// Copies get their own bytes, moves take them over
+	CompactEntry copy = compact;
+	EXPECT_EQ(copy, compact);
+	EXPECT_NE(copy.firstName().data(), compact.firstName().data());
+
+	CompactEntry moved = std::move(copy);
+	EXPECT_EQ(moved.toEntry(), entry);
+
+	CompactEntry assigned({ "Hamza", "Bo", "" }, "hamza", "bo");
+	assigned = moved;
+	EXPECT_EQ(assigned.toEntry(), entry);
+	assigned = CompactEntry({ "Hamza", "Bo", "" }, "hamza", "bo");
+	EXPECT_EQ(assigned.firstName(), "Hamza");
+
+	EXPECT_THROW(CompactEntry({ std::string(CompactEntry::max_field_length + 1, 'a'), "", "" }, "", ""),
+		std::length_error);
+}
+
+
+/// Tests that spilled bytes are allocated from the entry's memory resource, and from a std::pmr::vector's resource
+TEST(CompactEntryTests, SpilledToResource)
+{
+	CountingResource resource;
+	AddressBook::Entry entry = { std::string(100, 'A'), "Bo", "" };
+	{
+		CompactEntry compact(entry, std::string(100, 'a'), "bo", &resource);
+		EXPECT_GT(resource.in_use, 0);
+
+		// The vector constructs its entries with its own resource, copying bytes spilled to another one
+		std::pmr::vector<CompactEntry> entries(&resource);
+		entries.push_back(CompactEntry(entry, std::string(100, 'a'), "bo"));
+		entries.push_back(compact);
+		size_t in_use = resource.in_use;
+		EXPECT_GT(in_use, 2 * compact.firstName().size());
+
+		// Moves within the resource take the bytes over
+		std::swap(entries.at(0), entries.at(1));
+		entries.erase(entries.begin());
+		EXPECT_LT(resource.in_use, in_use);
+		EXPECT_EQ(entries.at(0).toEntry(), entry);
+
+		// Copies to another resource leave this one alone, and assigning keeps the resource of a spilled entry
+		std::pmr::vector<CompactEntry> copies(entries, std::pmr::new_delete_resource());
+		in_use = resource.in_use;
+		compact = copies.at(0);
+		EXPECT_EQ(resource.in_use, in_use);
+		EXPECT_EQ(compact, copies.at(0));
+	}
+	EXPECT_EQ(resource.in_use, 0);
+}
+
+
+/// Tests that equality compares all three fields
+TEST(CompactEntryTests, Equality)
+{
+	CompactEntry entry({ "Jayden", "Riddle", "+44 131 496 0609" }, "jayden", "riddle");
+
+	EXPECT_EQ(entry, CompactEntry({ "Jayden", "Riddle", "+44 131 496 0609" }, "jayden", "riddle"));
+	EXPECT_NE(entry, CompactEntry({ "Jayden", "Riddle", "+44 131 496 0600" }, "jayden", "riddle"));
+	EXPECT_NE(entry, CompactEntry({ "Jayde", "nRiddle", "+44 131 496 0609" }, "jayde", "nriddle"));
+	EXPECT_NE(entry, CompactEntry({ "jayden", "Riddle", "+44 131 496 0609" }, "jayden", "riddle"));
+}
+
+
+/// Tests that equal entries have equal fingerprints and that moving characters between fields changes it
+TEST(CompactEntryTests, Fingerprint)
+{
+	CompactEntry entry({ "Jayden", "Riddle", "+44 131 496 0609" }, "jayden", "riddle");
+
+	EXPECT_EQ(entry.fingerprint(), CompactEntry({ "Jayden", "Riddle", "+44 131 496 0609" }, "jayden", "riddle").fingerprint());
+	EXPECT_NE(entry.fingerprint(), CompactEntry({ "Jayden", "Riddle", "+44 131 496 0600" }, "jayden", "riddle").fingerprint());
+	EXPECT_NE(entry.fingerprint(), CompactEntry({ "Jayde", "nRiddle", "+44 131 496 0609" }, "jayde", "nriddle").fingerprint());
+
+	// An entry can be fingerprinted before it is packed, spilled or not
+	EXPECT_EQ(CompactEntry::fingerprint({ "Jayden", "Riddle", "+44 131 496 0609" }), entry.fingerprint());
+	AddressBookEntry long_entry{ std::string(100, 'a'), "Riddle", "0" };
+	EXPECT_EQ(CompactEntry::fingerprint(long_entry), CompactEntry(long_entry, std::string(100, 'a'), "riddle").fingerprint());
+}
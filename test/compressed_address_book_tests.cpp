@@ -0,0 +1,79 @@
+#include "compressed_address_book.h"
+#include "test_data.h"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// Tests that the snapshot answers queries exactly like the address book it was taken of
+TEST(CompressedAddressBookTests, SameResults)
+{
+	AddressBook ab = AddCompressedPeople();
+	CompressedAddressBook compressed(ab);
+	EXPECT_EQ(compressed.size(), 10);
+
+	EXPECT_EQ(compressed.sortedByFirstName(), ab.sortedByFirstName());
+	EXPECT_EQ(compressed.sortedByLastName(), ab.sortedByLastName());
+	for (std::string prefix : { "", "s", "SAL", "sally", "sallyx", "p", "b", "bo", "z", "+" }) {
+		EXPECT_EQ(compressed.find(prefix), ab.find(prefix)) << "prefix " << prefix;
+	}
+
+	// The snapshot doesn't change with the address book
+	ab.add({ "Zed", "Zulu", "" });
+	EXPECT_TRUE(compressed.find("zed").empty());
+
+	CompressedAddressBook empty((AddressBook()));
+	EXPECT_EQ(empty.size(), 0);
+	EXPECT_TRUE(empty.find("").empty());
+	EXPECT_TRUE(empty.sortedByLastName().empty());
+}
+
+
+/// Tests front coding across block boundaries
+TEST(CompressedAddressBookTests, FrontCodedDictionary)
+{
+	std::vector<std::string> strings;
+	for (size_t i = 0; i < 100; i++) {
+		strings.push_back("name" + std::to_string(1000 + i) + std::string(i % 3, 'x'));
+	}
+	strings.push_back(std::string(300, 'y'));
+	std::vector<std::string_view> views(strings.begin(), strings.end());
+
+	FrontCodedDictionary dictionary(views);
+	ASSERT_EQ(dictionary.size(), strings.size());
+	for (size_t i = 0; i < strings.size(); i++) {
+		EXPECT_EQ(dictionary.at(i), strings[i]);
+	}
+	EXPECT_THROW(dictionary.at(strings.size()), std::out_of_range);
+
+	// Lower bounds on block heads, inside blocks and past both ends
+	EXPECT_EQ(dictionary.lowerBound(""), 0);
+	EXPECT_EQ(dictionary.lowerBound("name1000"), 0);
+	EXPECT_EQ(dictionary.lowerBound("name1016"), 16);
+	EXPECT_EQ(dictionary.lowerBound("name1017"), 17);
+	EXPECT_EQ(dictionary.lowerBound("name1017y"), 18);
+	EXPECT_EQ(dictionary.lowerBound("name10999"), 100);
+	EXPECT_EQ(dictionary.lowerBound("z"), strings.size());
+
+	// Shared prefixes are only stored once
+	size_t plain_size = 0;
+	for (const std::string& string : strings) {
+		plain_size += string.size();
+	}
+	EXPECT_LT(dictionary.memoryUsage(), plain_size);
+}
+
+
+/// Tests packing phone numbers of odd and even lengths, and numbers that can't be packed
+TEST(CompressedAddressBookTests, PackedPhoneNumbers)
+{
+	std::vector<std::string> numbers = { "", "1", "12", "+44 (0) 161-496", "ext. 12", "0161 496 0311" };
+	PackedPhoneNumbers packed;
+	for (const std::string& number : numbers) {
+		packed.push_back(number);
+	}
+	for (size_t i = 0; i < numbers.size(); i++) {
+		EXPECT_EQ(packed.at(i), numbers[i]);
+	}
+}
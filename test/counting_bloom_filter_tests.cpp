@@ -0,0 +1,107 @@
+#include "counting_bloom_filter.h"
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+/// Hash of the ith test key
+static uint64_t keyHash(size_t i)
+{
+	return std::hash<std::string>{}("key" + std::to_string(i));
+}
+
+
+/// Tests that inserted keys are always found and that few other keys are
+TEST(CountingBloomFilterTests, NoFalseNegatives)
+{
+	CountingBloomFilter filter(10000);
+	EXPECT_EQ(filter.capacity(), 10000);
+	EXPECT_EQ(filter.bytes(), 10000 * CountingBloomFilter::counters_per_key / 2);
+
+	for (size_t i = 0; i < 10000; i++) {
+		filter.insert(keyHash(i));
+	}
+	for (size_t i = 0; i < 10000; i++) {
+		EXPECT_TRUE(filter.mayContain(keyHash(i)));
+	}
+
+	// About 2.5% false positives at capacity, allow some slack
+	size_t false_positives = 0;
+	for (size_t i = 10000; i < 20000; i++) {
+		false_positives += filter.mayContain(keyHash(i));
+	}
+	EXPECT_LT(false_positives, 500);
+
+	filter.clear();
+	EXPECT_FALSE(filter.mayContain(keyHash(0)));
+}
+
+
+/// Tests that erased keys are forgotten without losing the keys still in the filter
+TEST(CountingBloomFilterTests, Erase)
+{
+	CountingBloomFilter filter(1000);
+	for (size_t i = 0; i < 1000; i++) {
+		filter.insert(keyHash(i));
+	}
+	for (size_t i = 0; i < 1000; i += 2) {
+		filter.erase(keyHash(i));
+	}
+	for (size_t i = 1; i < 1000; i += 2) {
+		EXPECT_TRUE(filter.mayContain(keyHash(i)));
+	}
+
+	// Inserting the same key many times saturates its counters, it then stays in the filter for good
+	CountingBloomFilter saturated(16);
+	for (size_t i = 0; i < 20; i++) {
+		saturated.insert(keyHash(0));
+	}
+	for (size_t i = 0; i < 20; i++) {
+		saturated.erase(keyHash(0));
+	}
+	EXPECT_TRUE(saturated.mayContain(keyHash(0)));
+
+	CountingBloomFilter once(16);
+	once.insert(keyHash(0));
+	once.erase(keyHash(0));
+	EXPECT_FALSE(once.mayContain(keyHash(0)));
+}
+
+
+/// Tests that filling the slices of a filter from separate threads gives the same filter as filling it on one thread
+TEST(CountingBloomFilterTests, Slices)
+{
+	constexpr size_t slice_count = 4;
+	CountingBloomFilter whole(10000);
+	CountingBloomFilter sliced(10000);
+
+	std::vector<std::thread> threads;
+	for (size_t slice = 0; slice < slice_count; slice++) {
+		threads.emplace_back([&sliced, slice]() {
+			for (size_t i = 0; i < 10000; i++) {
+				if (sliced.sliceOf(keyHash(i), slice_count) == slice) {
+					sliced.insert(keyHash(i));
+				}
+			}
+		});
+	}
+	for (std::thread& thread : threads) {
+		thread.join();
+	}
+
+	// Every slice gets some of the keys
+	std::vector<size_t> slice_sizes(slice_count);
+	for (size_t i = 0; i < 10000; i++) {
+		whole.insert(keyHash(i));
+		slice_sizes.at(whole.sliceOf(keyHash(i), slice_count))++;
+	}
+	for (size_t size : slice_sizes) {
+		EXPECT_GT(size, 0);
+	}
+	for (size_t i = 0; i < 20000; i++) {
+		EXPECT_EQ(sliced.mayContain(keyHash(i)), whole.mayContain(keyHash(i)));
+	}
+}
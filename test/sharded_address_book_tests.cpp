@@ -0,0 +1,104 @@
+#include "sharded_address_book.h"
+#include "test_data.h"
+
+#include <gtest/gtest.h>
+#include <string>
+#include <algorithm>
+
+/// Tests that a sharded address book can't be created without any shards
+TEST(ShardedAddressBookTests, ZeroShards)
+{
+	EXPECT_THROW(ShardedAddressBook ab(0), std::invalid_argument) << "Expected invalid argument exception with 0 shards";
+}
+
+
+/// Tests that entries added across shards come back merged in first and last name order
+TEST(ShardedAddressBookTests, SortedListingsAreMerged)
+{
+	ShardedAddressBook ab(4);
+	for (auto& person : people) {
+		ab.add({ person[0], person[1], person[2] });
+	}
+
+	std::vector<AddressBook::Entry> results = ab.sortedByFirstName();
+	ASSERT_EQ(results.size(), 6);
+	EXPECT_EQ(results[0].first_name, "Aaran");
+	EXPECT_EQ(results[1].first_name, "Adriana");
+	EXPECT_EQ(results[2].first_name, "Hamza");
+	EXPECT_EQ(results[3].first_name, "Jayden");
+	EXPECT_EQ(results[4].first_name, "Phoenix");
+	EXPECT_EQ(results[5].first_name, "Sally");
+
+	results = ab.sortedByLastName();
+	ASSERT_EQ(results.size(), 6);
+	EXPECT_EQ(results[0].last_name, "Bo");
+	EXPECT_EQ(results[1].last_name, "Bond");
+	EXPECT_EQ(results[2].last_name, "Graham");
+	EXPECT_EQ(results[3].last_name, "Parks");
+	EXPECT_EQ(results[4].last_name, "Paul");
+	EXPECT_EQ(results[5].last_name, "Riddle");
+}
+
+
+/// Tests that add, remove and find are routed to the right shard
+TEST(ShardedAddressBookTests, AddFindRemove)
+{
+	ShardedAddressBook ab(3);
+	for (auto& person : people) {
+		ab.add({ person[0], person[1], person[2] });
+	}
+
+	// Duplicates always hash to the same shard so they are still rejected
+	AddressBook::Entry duplicate = { "Sally", "Graham", "+44 7700 900297" };
+	EXPECT_THROW(ab.add(duplicate), std::invalid_argument) << "Expected invalid argument exception with duplicate entry";
+
+	// "a" matches Aaran and Adriana even if they live in different shards
+	std::vector<AddressBook::Entry> results = ab.find("a");
+	ASSERT_EQ(results.size(), 2);
+
+	// "bo" matches both Bo and Bond
+	results = ab.find("BO");
+	ASSERT_EQ(results.size(), 2);
+
+	ab.remove(duplicate);
+	EXPECT_EQ(ab.find("Sally").size(), 0);
+	EXPECT_EQ(ab.sortedByFirstName().size(), 5);
+
+	EXPECT_THROW(ab.remove(duplicate), std::invalid_argument) << "Expected invalid argument exception with removed entry";
+
+	// The non throwing versions report the same failures
+	EXPECT_EQ(ab.tryRemove(duplicate), AddressBook::Status::NotFound);
+	EXPECT_EQ(ab.tryAdd(duplicate), AddressBook::Status::Ok);
+	EXPECT_EQ(ab.tryAdd(duplicate), AddressBook::Status::AlreadyExists);
+	EXPECT_EQ(ab.tryRemove(duplicate), AddressBook::Status::Ok);
+}
+
+
+/// Tests that find merges the shards into the same order as AddressBook::find
+TEST(ShardedAddressBookTests, FindIsMerged)
+{
+	ShardedAddressBook sharded(4);
+	AddressBook ab;
+	for (auto& person : people) {
+		sharded.add({ person[0], person[1], person[2] });
+		ab.add({ person[0], person[1], person[2] });
+	}
+	for (AddressBook::Entry person : { AddressBook::Entry{ "Bob", "Adams", "1" }, AddressBook::Entry{ "Pat", "Bailey", "2" },
+		AddressBook::Entry{ "Abe", "Zed", "3" }, AddressBook::Entry{ "Ola", "Abbot", "4" } }) {
+		sharded.add(person);
+		ab.add(person);
+	}
+
+	for (std::string prefix : { "a", "B", "p", "ab", "x", "" }) {
+		EXPECT_EQ(sharded.find(prefix), ab.find(prefix)) << "Prefix " << prefix;
+	}
+
+	// First name matches in first name order, then last name only matches in last name order
+	std::vector<AddressBook::Entry> results = sharded.find("a");
+	ASSERT_EQ(results.size(), 5);
+	EXPECT_EQ(results[0].first_name, "Aaran");
+	EXPECT_EQ(results[1].first_name, "Abe");
+	EXPECT_EQ(results[2].first_name, "Adriana");
+	EXPECT_EQ(results[3].last_name, "Abbot");
+	EXPECT_EQ(results[4].last_name, "Adams");
+}
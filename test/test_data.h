@@ -0,0 +1,96 @@
+#pragma once
+
+#include "address_book.h"
+
+#include <cstddef>
+#include <memory_resource>
+#include <string>
+
+///  Sample test data
+inline const std::string people[][3] = {
+		{"Sally", "Graham", "+44 7700 900297"},
+		{"Phoenix", "Bond", "0161 496 0311"},
+		{"Aaran", "Parks", ""},
+		{"Jayden", "Riddle", "+44 131 496 0609"},
+		{"Adriana", "Paul", "(739) 391-4868"},
+		{"Hamza", "Bo", "+44 131 496 0571"}
+	};
+
+///  Sample test data
+inline AddressBook AddTestPeople()
+{
+	AddressBook addressBook;
+	// Add all of the test data to the address book
+	for (auto person : people)
+	{
+		AddressBook::Entry entry = { person[0], person[1], person[2] };
+		addressBook.add(entry);
+	}
+	return addressBook;
+}
+
+
+///  Sample test data, with first and last names that share prefixes
+inline AddressBook AddAutocompletePeople()
+{
+	AddressBook ab;
+	ab.add({ "Jayden", "Riddle", "+44 131 496 0609" });
+	ab.add({ "Jacob", "Smith", "000000000" });
+	ab.add({ "James", "Jayne", "000000001" });
+	ab.add({ "Sally", "Jarvis", "+44 7700 900297" });
+	ab.add({ "Hamza", "Bo", "+44 131 496 0571" });
+	return ab;
+}
+
+
+///  Sample test data, with names that differ only in case and phone numbers that can't be packed
+inline AddressBook AddCompressedPeople()
+{
+	AddressBook ab;
+	ab.add({ "Sally", "Graham", "+44 7700 900297" });
+	ab.add({ "Phoenix", "Bond", "0161 496 0311" });
+	ab.add({ "Aaran", "Parks", "" });
+	ab.add({ "Jayden", "Riddle", "+44 131 496 0609" });
+	ab.add({ "Adriana", "Paul", "(739) 391-4868" });
+	ab.add({ "Hamza", "Bo", "+44 131 496 0571 ext. 12" });
+	ab.add({ "SALLY", "Bond", "555" });
+	ab.add({ "sally", "Graham", "556" });
+	ab.add({ "Paul", "Sally", "557" });
+	ab.add({ "", "Solo", "1" });
+	return ab;
+}
+
+
+/// Entry i of a generated batch, named First<i % first_names> Last<i % last_names> so that names repeat
+inline AddressBook::Entry numberedEntry(size_t i, size_t first_names, size_t last_names)
+{
+	return { "First" + std::to_string(i % first_names), "Last" + std::to_string(i % last_names), std::to_string(i) };
+}
+
+
+/// A memory resource that counts the bytes allocated through it, in total and not yet deallocated
+class CountingResource : public std::pmr::memory_resource
+{
+public:
+	size_t allocated = 0;
+	size_t in_use = 0;
+
+private:
+	void* do_allocate(size_t bytes, size_t alignment) override
+	{
+		allocated += bytes;
+		in_use += bytes;
+		return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+	}
+
+	void do_deallocate(void* p, size_t bytes, size_t alignment) override
+	{
+		in_use -= bytes;
+		std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+	}
+
+	bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+	{
+		return this == &other;
+	}
+};
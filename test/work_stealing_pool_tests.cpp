@@ -0,0 +1,75 @@
+#include "work_stealing_pool.h"
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+/// Tests that every index is run exactly once, with and without worker threads
+TEST(WorkStealingPoolTests, RunsEveryIndexOnce)
+{
+	for (size_t thread_count : { 0, 1, 4 }) {
+		WorkStealingPool pool(thread_count);
+		EXPECT_EQ(pool.threadCount(), thread_count);
+
+		std::vector<std::atomic<int>> runs(1000);
+		pool.parallelFor(runs.size(), [&runs](size_t i) { runs.at(i)++; });
+		for (std::atomic<int>& count : runs) {
+			EXPECT_EQ(count, 1);
+		}
+
+		// Nothing to run
+		pool.parallelFor(0, [](size_t) { FAIL(); });
+	}
+}
+
+
+/// Tests that jobs can share out work of their own without deadlocking the pool
+TEST(WorkStealingPoolTests, NestedParallelFor)
+{
+	WorkStealingPool pool(2);
+
+	std::atomic<size_t> total{ 0 };
+	pool.parallelFor(8, [&](size_t i) {
+		pool.parallelFor(100, [&total, i](size_t j) { total += i * 100 + j; });
+	});
+
+	// Sum of 0 to 799
+	EXPECT_EQ(total, 799 * 800 / 2);
+}
+
+
+/// Tests that an exception thrown by a job is rethrown once every job has finished
+TEST(WorkStealingPoolTests, Exceptions)
+{
+	WorkStealingPool pool(3);
+
+	std::atomic<size_t> finished{ 0 };
+	EXPECT_THROW(pool.parallelFor(64, [&finished](size_t i) {
+		if (i % 16 == 5) {
+			throw std::runtime_error("Job failed");
+		}
+		finished++;
+	}), std::runtime_error);
+	EXPECT_EQ(finished, 60);
+
+	// The pool still works afterwards
+	finished = 0;
+	pool.parallelFor(10, [&finished](size_t) { finished++; });
+	EXPECT_EQ(finished, 10);
+}
+
+
+/// Tests many short parallelFor calls in a row, where the caller returns right as the last job finishes
+TEST(WorkStealingPoolTests, ManyShortCalls)
+{
+	WorkStealingPool pool(3);
+
+	std::atomic<size_t> total{ 0 };
+	for (size_t call = 0; call < 5000; call++) {
+		pool.parallelFor(call % 4 + 1, [&total](size_t) { total++; });
+	}
+
+	// 1 + 2 + 3 + 4 jobs for every 4 calls
+	EXPECT_EQ(total, 5000 / 4 * 10);
+}